@@ -0,0 +1,70 @@
+# Runs <BENCHMARK>_<isa> for every ISA in ISAS (comma separated) that cpu_supports
+# reports as usable on this machine. The JSON results are merged into one table of CPU
+# times, one column per ISA, that is printed and written to <BENCHMARK>_isa.csv.
+#
+# Expected variables: BENCHMARK, ISAS, BINARY_DIR, CPU_SUPPORTS
+# Optional: ARGS (comma separated extra arguments for the benchmark binaries)
+string(REPLACE "," ";" ISAS "${ISAS}")
+string(REPLACE "," ";" ARGS "${ARGS}")
+
+set(columns)
+set(rows)
+foreach(isa ${ISAS})
+   execute_process(COMMAND "${CPU_SUPPORTS}" ${isa} RESULT_VARIABLE supported)
+   if(NOT supported EQUAL 0)
+      message(STATUS "Skipping ${BENCHMARK}_${isa}: not supported by this CPU")
+   else()
+      set(json "${BINARY_DIR}/${BENCHMARK}_${isa}.json")
+      message(STATUS "Running ${BENCHMARK}_${isa}")
+      execute_process(
+         COMMAND "${BINARY_DIR}/${BENCHMARK}_${isa}" --benchmark_out=${json}
+                 --benchmark_out_format=json ${ARGS}
+         RESULT_VARIABLE ok)
+      if(NOT ok EQUAL 0)
+         message(FATAL_ERROR "${BENCHMARK}_${isa} failed")
+      endif()
+      list(APPEND columns ${isa})
+
+      # benchmark's JSON writer puts every key on its own line; names are hashed since
+      # they are not usable as CMake variable names or list entries
+      file(STRINGS "${json}" lines REGEX "^ *\"(name|cpu_time|time_unit)\": ")
+      foreach(line ${lines})
+         if(line MATCHES "^ *\"name\": \"(.*)\",?$")
+            string(MD5 key "${CMAKE_MATCH_1}")
+            if(NOT DEFINED name_${key})
+               set(name_${key} "${CMAKE_MATCH_1}")
+               list(APPEND rows ${key})
+            endif()
+         elseif(line MATCHES "^ *\"cpu_time\": ([-+.0-9eE]+),?$")
+            set(time_${key}_${isa} ${CMAKE_MATCH_1})
+         elseif(line MATCHES "^ *\"time_unit\": \"(.*)\",?$")
+            set(unit_${key} ${CMAKE_MATCH_1})
+         endif()
+      endforeach()
+   endif()
+endforeach()
+
+if(NOT columns)
+   message(FATAL_ERROR "None of the ISAs ${ISAS} is supported by this CPU")
+endif()
+
+string(REPLACE ";" "," header "benchmark,unit,${columns},fastest")
+set(csv "${header}\n")
+message("${header}")
+foreach(key ${rows})
+   set(line "\"${name_${key}}\",${unit_${key}}")
+   set(best)
+   foreach(isa ${columns})
+      set(t "${time_${key}_${isa}}")
+      set(line "${line},${t}")
+      if(NOT t STREQUAL "" AND (NOT best OR t LESS best_time))
+         set(best ${isa})
+         set(best_time ${t})
+      endif()
+   endforeach()
+   set(line "${line},${best}")
+   set(csv "${csv}${line}\n")
+   message("${line}")
+endforeach()
+file(WRITE "${BINARY_DIR}/${BENCHMARK}_isa.csv" "${csv}")
+message(STATUS "Wrote ${BINARY_DIR}/${BENCHMARK}_isa.csv")
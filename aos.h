@@ -23,36 +23,26 @@ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
 #ifndef AOS_H
 #define AOS_H
+#include <limits>
 #include <string>
 #include <vector>
-#include <random>
 #include <Vc/vector>
+#include "inputgenerator.h"
 
 using Vc::Common::InterleavedMemoryWrapper;
 
 template <typename T>
-using CoordinateContainer = Vc::vector<Coordinate<T>, Vc::Allocator<Coordinate<T>>>;
+using CoordinateContainer =
+    Vc::vector<Coordinate<T>, FirstTouchAllocator<Coordinate<T>>>;
 template <typename T>
 using PolarCoordinateContainer =
     Vc::vector<PolarCoordinate<T>, Vc::Allocator<PolarCoordinate<T>>>;
 
 //! Creates random numbers for AoS
 template <typename B, typename T> void simulateInputAos(T &input, const size_t size) {
-  typedef typename T::iterator Iterator;
-  using Dist = typename std::conditional<std::is_integral<B>::value,
-                                         std::uniform_int_distribution<B>,
-                                         std::uniform_real_distribution<B>>::type;
-
-  std::mt19937 engine(std::random_device{}());
-  Dist random(std::numeric_limits<B>::min(), std::numeric_limits<B>::max());
-  Iterator aktElement(input.begin());
-  Iterator endElement(input.begin() + size);
-
-  while (aktElement != endElement) {
-    aktElement->x = random(engine);
-    aktElement->y = random(engine);
-    aktElement++;
-  }
+  static_assert(sizeof(Coordinate<B>) == 2 * sizeof(B), "x and y must be contiguous");
+  fillUniform(reinterpret_cast<B *>(input.data()), 2 * size, std::numeric_limits<B>::min(),
+              std::numeric_limits<B>::max());
 }
 
 template <typename T> struct AosLayout {
@@ -135,7 +125,7 @@ template <typename T> struct InterleavedAccessImpl : public AosLayout<T> {
 };
 
 template <typename T> struct AosGatherScatterAccessImpl : public AosLayout<T> {
-  typedef typename T::IndexType IT;
+  typedef IndexesFor<T> IT;
   IT indexes;
 
   AosGatherScatterAccessImpl(size_t containerSize)
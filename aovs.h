@@ -24,24 +24,22 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
 #ifndef AOVS_H
 #define AOVS_H
 
+#include "inputgenerator.h"
+
 template <typename T>
 using VectorizedCoordinateContainer =
-    std::vector<Coordinate<T>, Vc::Allocator<Coordinate<T>>>;
+    std::vector<Coordinate<T>, FirstTouchAllocator<Coordinate<T>>>;
 template <typename T>
 using VectorizedPolarCoordinateContainer =
     std::vector<PolarCoordinate<T>, Vc::Allocator<PolarCoordinate<T>>>;
 
+//! Creates random numbers in [0, 1) for AoVS, like T::Random()
 template <typename T>
 void simulateInputAovs(VectorizedCoordinateContainer<T> &input, const size_t size) {
-  typename VectorizedCoordinateContainer<T>::iterator aktElement = input.begin();
-  typename VectorizedCoordinateContainer<T>::iterator endElement = (input.begin() + size);
-
-  while (aktElement != endElement) {
-    aktElement->x = T::Random();
-    aktElement->y = T::Random();
-
-    aktElement++;
-  }
+  using TY = typename T::value_type;
+  static_assert(sizeof(Coordinate<T>) == 2 * T::size() * sizeof(TY),
+                "the vectors of x and y must be contiguous");
+  fillUniform(reinterpret_cast<TY *>(input.data()), 2 * T::size() * size, TY(0), TY(1));
 }
 
 template <typename T> struct AovsLayout {
@@ -52,7 +50,8 @@ template <typename T> struct AovsLayout {
   OC outputValues;
 
   AovsLayout(size_t containerSize)
-      : inputValues(containerSize / T::size()), outputValues(containerSize / T::size()) {
+      : inputValues(numberOfChunks(containerSize, T::size())),
+        outputValues(numberOfChunks(containerSize, T::size())) {
     simulateInputAovs<T>(inputValues, inputValues.size());
   }
 
@@ -25,6 +25,7 @@ ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
 
 #include "benchmark.h"
+#include "roofline.h"
 
 template <bool T> struct HasTwoOps { static constexpr bool hasTwoOps = T; };
 
@@ -67,6 +68,14 @@ Vc_MAKE_TWO_OP_OPERATOR(Atan2, Vc::atan2);
 Vc_MAKE_TWO_OP_OPERATOR(Min, Vc::min);
 Vc_MAKE_TWO_OP_OPERATOR(Max, Vc::max);
 
+// FLOPs per entry of the operations that are compared with the peak FLOP/s (see
+// roofline.h); the others have no well-defined FLOP count
+template <typename P> struct FlopsOf : std::integral_constant<int, 0> {};
+template <> struct FlopsOf<Add> : std::integral_constant<int, 1> {};
+template <> struct FlopsOf<Sub> : std::integral_constant<int, 1> {};
+template <> struct FlopsOf<Mul> : std::integral_constant<int, 1> {};
+template <> struct FlopsOf<Div> : std::integral_constant<int, 1> {};
+
 template <typename T, typename P>
 inline typename std::enable_if<P::hasTwoOps, T>::type calculate(T &x, T &y)
 {
@@ -85,24 +94,32 @@ template <typename TT> void oneOp(benchmark::State &state) {
 
   T a = 1, b = 2, c = 3, d = 4, e = 5;
 
-  for (auto _ : state) {
+  // one iteration with the operation f; the overhead is calibrated with f returning x
+  const auto iteration = [&](auto f) {
     fake_modification(a);
     fake_modification(b);
     fake_modification(c);
     fake_modification(d);
     fake_modification(e);
-    do_not_optimize(calculate<T, P>(a, b));
-    do_not_optimize(calculate<T, P>(a, c));
-    do_not_optimize(calculate<T, P>(a, d));
-    do_not_optimize(calculate<T, P>(a, e));
-    do_not_optimize(calculate<T, P>(b, c));
-    do_not_optimize(calculate<T, P>(b, d));
-    do_not_optimize(calculate<T, P>(b, e));
-    do_not_optimize(calculate<T, P>(c, d));
-    do_not_optimize(calculate<T, P>(c, e));
-    do_not_optimize(calculate<T, P>(d, e));
+    do_not_optimize(f(a, b));
+    do_not_optimize(f(a, c));
+    do_not_optimize(f(a, d));
+    do_not_optimize(f(a, e));
+    do_not_optimize(f(b, c));
+    do_not_optimize(f(b, d));
+    do_not_optimize(f(b, e));
+    do_not_optimize(f(c, d));
+    do_not_optimize(f(c, e));
+    do_not_optimize(f(d, e));
+  };
+  netLoop(state, [&] { iteration([](T &x, T &y) { return calculate<T, P>(x, y); }); },
+          [&] { iteration([](T &x, T &) { return x; }); });
+  const double items = double(state.iterations()) * element_count<T>::value * 10;
+  state.counters["Rate"] = items;
+  if (FlopsOf<P>::value > 0) {
+    // registers only: no bytes, the roof is the peak FLOP/s
+    reportRoofline<T>(state, items, FlopsOf<P>::value, 0, 0);
   }
-  state.counters["Rate"] = state.iterations() * element_count<T>::value * 10;
 }
 
 Vc_BENCHMARK_TEMPLATE(
@@ -110,4 +127,23 @@ Vc_BENCHMARK_TEMPLATE(
                   outer_product<Typelist<Mod>, all_integral_vectors>,
                   outer_product<Typelist<Sqrt, Rsqrt, Abs, Round, Log, Log2, Log10, Exp,
                                          Asin, Atan, Atan2, Min, Max>,
-                                all_real_vectors>>);
+                                all_real_vectors>>)
+    ->SubtractOverhead()
+    ->TrackFrequency();
+
+// SMT contention on the vector units: two threads on the hardware threads of one core
+// against two threads on separate cores. Compare Rate with the single-threaded oneOp.
+template <typename TT> void sameCore(benchmark::State &state) { oneOp<TT>(state); }
+template <typename TT> void separateCores(benchmark::State &state) { oneOp<TT>(state); }
+
+using ContendedOps = outer_product<Typelist<Add, Mul, Div, Sqrt>, all_real_vectors>;
+Vc_BENCHMARK_TEMPLATE(sameCore, ContendedOps)
+    ->Pin(Pinning::SmtSiblings)
+    ->Threads(2)
+    ->SubtractOverhead()
+    ->TrackFrequency();
+Vc_BENCHMARK_TEMPLATE(separateCores, ContendedOps)
+    ->Pin(Pinning::PhysicalCores)
+    ->Threads(2)
+    ->SubtractOverhead()
+    ->TrackFrequency();
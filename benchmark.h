@@ -27,14 +27,105 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
 #define BENCHMARK_H
 
 #include <benchmark/benchmark.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <Vc/cpuid.h>
+#include "frequency.h"
+#include "inputgenerator.h"
+#include "statistics.h"
+#include "topology.h"
 #include "typetostring.h"
 
+inline void warmUpUntilSteady(double maxSeconds);
+
+// Settings that TemplateWrapper applies around every run of the benchmarks it registered.
+struct RunOptions {
+  double warmUp = 0;                // at most this many seconds of warm-up (0: none)
+  Pinning pinning = Pinning::None;  // placement of the benchmark threads (topology.h)
+  bool trackFrequency = false;      // report the core frequency (frequency.h)
+};
+
+// Soak mode: runs a benchmark for the given number of seconds, split into slices that
+// are reported individually, and adds the aggregate "drift" (see statistics.h) of the
+// time, the counters and the core frequency over the run.
+inline void soak(benchmark::internal::Benchmark *p, RunOptions &options, double seconds,
+                 int slices) {
+  p->Repetitions(slices)->MinTime(seconds / slices)->ComputeStatistics(
+      "drift", statistics::drift);
+  options.trackFrequency = true;
+}
+
+// Every benchmark registered through a TemplateWrapper with its options, so that
+// command line flags can apply to all of them.
+struct RegisteredBenchmark {
+  benchmark::internal::Benchmark *benchmark;
+  std::shared_ptr<RunOptions> options;
+};
+
+inline std::vector<RegisteredBenchmark> &registeredBenchmarks() {
+  static std::vector<RegisteredBenchmark> all;
+  return all;
+}
+
+//! Removes --soak=<seconds> from argv and soaks every benchmark for that long (select
+//! them with --benchmark_filter); returns the new argc
+inline int parseSoakFlag(int argc, char **argv) {
+  int out = 1;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strncmp(argv[i], "--soak=", 7) == 0) {
+      const double seconds = std::strtod(argv[i] + 7, nullptr);
+      for (auto &r : registeredBenchmarks()) {
+        soak(r.benchmark, *r.options, seconds, 20);
+      }
+    } else {
+      argv[out++] = argv[i];
+    }
+  }
+  argv[out] = nullptr;
+  return out;
+}
+
 struct TemplateWrapper {
   std::vector<benchmark::internal::Benchmark *> benchmarks;
+  std::shared_ptr<RunOptions> options = std::make_shared<RunOptions>();
 
   void append(benchmark::internal::Benchmark *ptr) { benchmarks.push_back(ptr); }
 
+  void append(const char *name, void (*fptr)(benchmark::State &)) {
+    auto opts = options;
+    auto warm = std::make_shared<std::atomic<bool>>(false);
+    auto run = [opts, warm, fptr](benchmark::State &state) {
+      const ScopedPinning pin(state, opts->pinning);
+      if (state.error_occurred()) {
+        return;
+      }
+      if (opts->warmUp > 0 && !warm->load()) {
+        warmUpUntilSteady(opts->warmUp);
+        warm->store(true);
+      }
+      if (opts->trackFrequency) {
+        FrequencyMeter meter;
+        meter.start();
+        fptr(state);
+        meter.stop();
+        meter.report(state);
+      } else {
+        fptr(state);
+      }
+    };
+    append(benchmark::RegisterBenchmark(name, run));
+    registeredBenchmarks().push_back({benchmarks.back(), options});
+  }
+
   TemplateWrapper *operator->() { return this; }
 
   TemplateWrapper &Arg(int x) {
@@ -125,32 +216,107 @@ struct TemplateWrapper {
     return *this;
   }
 
+  // Pins the threads of every run with the given policy (see topology.h) and labels the
+  // run with the CPUs used. Combine with Threads/ThreadRange.
+  TemplateWrapper &Pin(Pinning policy) {
+    options->pinning = policy;
+    return *this;
+  }
+
+  // Reports the effective core frequency during each run as GHz and FreqRatio (see
+  // frequency.h), to tell downclocking by wide vector code from slower code.
+  TemplateWrapper &TrackFrequency() {
+    options->trackFrequency = true;
+    return *this;
+  }
+
+  // See soak(); --soak=<seconds> does the same for every benchmark.
+  TemplateWrapper &Soak(double seconds, int slices = 20) {
+    for (auto &p : benchmarks) {
+      soak(p, *options, seconds, slices);
+    }
+    return *this;
+  }
+
+  TemplateWrapper &Repetitions(int n) {
+    for (auto &p : benchmarks) {
+      p->Repetitions(n);
+    }
+
+    return *this;
+  }
+
+  TemplateWrapper &ReportAggregatesOnly(bool value = true) {
+    for (auto &p : benchmarks) {
+      p->ReportAggregatesOnly(value);
+    }
+
+    return *this;
+  }
+
+  // Adds the aggregates "mad", "ci95" and "steady" (see statistics.h) to the
+  // mean/median/stddev of repeated runs.
+  TemplateWrapper &RobustStatistics() {
+    for (auto &p : benchmarks) {
+      p->ComputeStatistics("mad", statistics::mad)
+          ->ComputeStatistics("ci95", statistics::ci95)
+          ->ComputeStatistics("steady", statistics::steadyMean);
+    }
+
+    return *this;
+  }
+
+  // Busy work before the first run of each benchmark until its speed is steady (see
+  // warmUpUntilSteady), so that it does not start at an idle clock frequency.
+  TemplateWrapper &WarmUp(double maxSeconds) {
+    options->warmUp = maxSeconds;
+    return *this;
+  }
+
+  // Reports the time of netLoop() minus its calibrated loop overhead (UseManualTime).
+  // Only for benchmarks that run their iterations through netLoop(): the time of all
+  // others would be reported as 0.
+  TemplateWrapper &SubtractOverhead() {
+    for (auto &p : benchmarks) {
+      p->UseManualTime();
+    }
+
+    return *this;
+  }
+
+  // Everything above that applies to any benchmark, for noisy (shared) machines:
+  // results are only reported as aggregates over the given number of repetitions.
+  TemplateWrapper &NoiseRobust(int repetitions = 10) {
+    return Repetitions(repetitions).ReportAggregatesOnly().RobustStatistics().WarmUp(1);
+  }
+
   operator int() { return 0; }
 };
 
+template <class TArg>
+void appendBenchmark(TemplateWrapper &wrapper, const char *name,
+                     void (*fptr)(benchmark::State &)) {
+  const std::string fullName = std::string(name) + '<' + typeToString<TArg>() + '>';
+  wrapper.append(fullName.c_str(), fptr);
+}
+
+// Registers n_<T> for every T in the Typelist __VA_ARGS__, in list order, via a single
+// pack expansion (no recursive instantiation per index).
 #define Vc_BENCHMARK_TEMPLATE(n_, ...)                                                   \
-  template <unsigned int N>                                                              \
-  TemplateWrapper BENCHMARK_PRIVATE_CONCAT(typeListFunc, n_, __LINE__)() {               \
-    using TArg = __VA_ARGS__::at<N>;                                                     \
-    constexpr auto *fptr = n_<TArg>;                                                     \
-    static std::string name = #n_"<" + typeToString<TArg>() + '>';                       \
-    TemplateWrapper wrapper =                                                            \
-        BENCHMARK_PRIVATE_CONCAT(typeListFunc, n_, __LINE__)<N - 1>();                   \
-    wrapper.append(benchmark::RegisterBenchmark(name.c_str(), fptr));                    \
-    return wrapper;                                                                      \
-  }                                                                                      \
-                                                                                         \
-  template <>                                                                            \
-  TemplateWrapper BENCHMARK_PRIVATE_CONCAT(typeListFunc, n_, __LINE__)<0u>() {           \
-    using TArg = __VA_ARGS__::at<0>;                                                     \
-    constexpr auto *fptr = n_<TArg>;                                                     \
-    static std::string name = #n_"<" + typeToString<TArg>() + '>';                       \
+  template <std::size_t... Is>                                                           \
+  TemplateWrapper BENCHMARK_PRIVATE_CONCAT(typeListFunc, n_, __LINE__)(                  \
+      std::index_sequence<Is...>) {                                                      \
+    using List = __VA_ARGS__;                                                            \
     TemplateWrapper wrapper;                                                             \
-    wrapper.append(benchmark::RegisterBenchmark(name.c_str(), fptr));                    \
+    int unused[] = {0, (appendBenchmark<typename List::template at<Is>>(                 \
+                            wrapper, #n_, n_<typename List::template at<Is>>),           \
+                        0)...};                                                          \
+    (void)unused;                                                                        \
     return wrapper;                                                                      \
   }                                                                                      \
   int BENCHMARK_PRIVATE_CONCAT(variable, n_, __LINE__) =                                 \
-      BENCHMARK_PRIVATE_CONCAT(typeListFunc, n_, __LINE__)<__VA_ARGS__::size() - 1>()
+      BENCHMARK_PRIVATE_CONCAT(typeListFunc, n_, __LINE__)(                              \
+          std::make_index_sequence<__VA_ARGS__::size()>())
 
 ///////////////////////////////////////////////////////////////////////////////
 // element_count<T>
@@ -160,6 +326,15 @@ template <class T>
 struct element_count<T, decltype((void)T::size())>
     : std::integral_constant<std::size_t, T::size()> {};
 
+///////////////////////////////////////////////////////////////////////////////
+// entry_type<T>: the element type of a Vc vector type, or T itself for fundamental types
+template <class T, bool = std::is_arithmetic<T>::value> struct entry_type {
+  using type = T;
+};
+template <class V> struct entry_type<V, false> {
+  using type = typename V::EntryType;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 // fake_modification(x)
 template <class T>
@@ -226,5 +401,161 @@ template <class T, class U> void do_not_optimize(const std::pair<T, U> &x) {
   do_not_optimize(x.second);
 }
 
-BENCHMARK_MAIN();
+///////////////////////////////////////////////////////////////////////////////
+// netLoop(state, body, barriers)
+// Runs body() once per benchmark iteration. barriers() is the same iteration without
+// the benchmarked work: the same fake_modification/do_not_optimize calls on the same
+// types. Its time per iteration is calibrated once per benchmark (the fastest of several
+// runs), subtracted from the time of the loop and passed to SetIterationTime, which is
+// the reported time in groups registered with SubtractOverhead(). Adds the counter
+// Overhead, the subtracted seconds per iteration.
+template <class Barriers> double loopOverhead(Barriers &barriers) {
+  using clock = std::chrono::steady_clock;
+  constexpr int N = 1 << 16;
+  double best = std::numeric_limits<double>::max();
+  for (int run = 0; run < 5; ++run) {
+    const auto start = clock::now();
+    for (int i = 0; i < N; ++i) {
+      barriers();
+    }
+    best = std::min(best, std::chrono::duration<double>(clock::now() - start).count());
+  }
+  return best / N;
+}
+
+template <class Body, class Barriers>
+void netLoop(benchmark::State &state, Body &&body, Barriers &&barriers) {
+  using clock = std::chrono::steady_clock;
+  static const double overhead = loopOverhead(barriers);
+  const auto start = clock::now();
+  for (auto _ : state) {
+    body();
+  }
+  const double seconds = std::chrono::duration<double>(clock::now() - start).count();
+  state.SetIterationTime(std::max(0., seconds - overhead * state.iterations()));
+  state.counters["Overhead"] =
+      benchmark::Counter(overhead, benchmark::Counter::kAvgThreads);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// warmUpUntilSteady(maxSeconds)
+// Repeats a fixed chunk of busy work until three consecutive chunks take the same time
+// within 1%, i.e. until the clock frequency has settled, or until maxSeconds have passed.
+inline void warmUpUntilSteady(double maxSeconds) {
+  using clock = std::chrono::steady_clock;
+  const auto end = clock::now() + std::chrono::duration_cast<clock::duration>(
+                                      std::chrono::duration<double>(maxSeconds));
+  double x = 1;
+  double previous = 0;
+  int steady = 0;
+  while (steady < 2 && clock::now() < end) {
+    const auto start = clock::now();
+    for (int i = 0; i < 1 << 18; ++i) {
+      x = x * 1.000001 + 1e-9;
+      fake_modification(x);
+    }
+    const double t = std::chrono::duration<double>(clock::now() - start).count();
+    steady = std::abs(t - previous) <= 0.01 * previous ? steady + 1 : 0;
+    previous = t;
+  }
+  do_not_optimize(x);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// cacheLevels()
+// The data caches from L1 outwards with their sizes in bytes, followed by DRAM (with
+// unbounded size). Levels Vc::CpuId does not report (size 0) are left out.
+struct CacheLevel {
+  const char *name;
+  std::size_t size;
+};
+
+inline const std::vector<CacheLevel> &cacheLevels() {
+  static const std::vector<CacheLevel> levels = [] {
+    Vc::CpuId::init();
+    std::vector<CacheLevel> r;
+    for (const CacheLevel &level :
+         {CacheLevel{"L1", std::size_t(Vc::CpuId::L1Data())},
+          CacheLevel{"L2", std::size_t(Vc::CpuId::L2Data())},
+          CacheLevel{"L3", std::size_t(Vc::CpuId::L3Data())}}) {
+      if (level.size > 0 && (r.empty() || level.size > r.back().size)) {
+        r.push_back(level);
+      }
+    }
+    r.push_back({"DRAM", std::numeric_limits<std::size_t>::max()});
+    return r;
+  }();
+  return levels;
+}
+
+//! The smallest level of cacheLevels() that holds workingSet bytes
+inline const CacheLevel &cacheLevelOf(std::size_t workingSet) {
+  for (const auto &level : cacheLevels()) {
+    if (workingSet <= level.size) {
+      return level;
+    }
+  }
+  return cacheLevels().back();
+}
+
+inline void labelCacheLevel(benchmark::State &state, std::size_t workingSet) {
+  state.SetLabel(cacheLevelOf(workingSet).name);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// cacheSweep(function, bytesPerElement)
+// Adds element counts whose working sets (count * bytesPerElement) lie densely just
+// below and above the size of each cache level and of 4x the last level cache, which
+// is firmly in DRAM. Use cacheSweepOf<Bytes> with Apply(); with Bytes = 1 the argument
+// is the working set in bytes.
+inline void cacheSweep(benchmark::internal::Benchmark *function,
+                       std::size_t bytesPerElement) {
+  std::vector<std::size_t> boundaries;
+  for (const auto &level : cacheLevels()) {
+    if (level.size != std::numeric_limits<std::size_t>::max()) {
+      boundaries.push_back(level.size);
+    }
+  }
+  if (boundaries.empty()) {
+    boundaries.push_back(std::size_t(8) << 20);
+  }
+  boundaries.push_back(4 * boundaries.back());
+
+  std::vector<std::size_t> counts = {
+      std::max<std::size_t>(boundaries.front() / 8 / bytesPerElement, 1)};
+  for (std::size_t size : boundaries) {
+    for (std::size_t eighths : {4, 6, 7, 8, 9, 10, 12}) {
+      counts.push_back(std::max<std::size_t>(size * eighths / 8 / bytesPerElement, 1));
+    }
+  }
+  std::sort(counts.begin(), counts.end());
+  counts.erase(std::unique(counts.begin(), counts.end()), counts.end());
+  for (std::size_t n : counts) {
+    function->Arg(static_cast<int>(
+        std::min<std::size_t>(n, std::numeric_limits<int>::max())));
+  }
+}
+
+template <std::size_t BytesPerElement>
+void cacheSweepOf(benchmark::internal::Benchmark *function) {
+  cacheSweep(function, BytesPerElement);
+}
+
+// BENCHMARK_MAIN plus --seed and --corpus (see inputgenerator.h) and --soak
+int main(int argc, char **argv) {
+  argc = parseInputFlags(argc, argv);
+  argc = parseSoakFlag(argc, argv);
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  // the reference for FreqRatio, while no vector code has lowered the clock yet
+  for (const auto &r : registeredBenchmarks()) {
+    if (r.options->trackFrequency) {
+      FrequencyMeter::scalarFrequency();
+      break;
+    }
+  }
+  benchmark::RunSpecifiedBenchmarks();
+}
 #endif // BENCHMARK_H
@@ -0,0 +1,64 @@
+/*{{{
+Copyright © 2018 Matthias Kretz <kretz@kde.org>
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the names of contributing organizations nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+}}}*/
+
+
+#include <Vc/cpuid.h>
+#include <Vc/support.h>
+#include <cstdio>
+#include <string>
+
+// Exits with 0 if the CPU and OS support the given ISA level of the build matrix
+// (see BUILD_ISA_MATRIX in CMakeLists.txt), 1 if not, 2 on usage errors. This program
+// is built without architecture flags so that it runs everywhere.
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    std::fprintf(stderr, "usage: %s sse2|sse42|avx|avx2|avx512\n", argv[0]);
+    return 2;
+  }
+  Vc::CpuId::init();
+  const std::string isa = argv[1];
+  bool supported = false;
+  if (isa == "sse2") {
+    supported = Vc::isImplementationSupported(Vc::SSE2Impl);
+  } else if (isa == "sse42") {
+    supported = Vc::isImplementationSupported(Vc::SSE42Impl) && Vc::CpuId::hasPopcnt();
+  } else if (isa == "avx") {
+    supported = Vc::isImplementationSupported(Vc::AVXImpl);
+  } else if (isa == "avx2") {
+    supported = Vc::isImplementationSupported(Vc::AVX2Impl) && Vc::CpuId::hasFma() &&
+                Vc::CpuId::hasBmi2();
+  } else if (isa == "avx512") {
+    // Vc::CpuId does not know about AVX-512, so ask the compiler runtime instead
+    supported = Vc::isImplementationSupported(Vc::AVX2Impl) &&
+                __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl") &&
+                __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512dq");
+  } else {
+    std::fprintf(stderr, "unknown ISA '%s'\n", argv[1]);
+    return 2;
+  }
+  return supported ? 0 : 1;
+}
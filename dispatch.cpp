@@ -0,0 +1,248 @@
+/*{{{
+Copyright © 2018 Matthias Kretz <kretz@kde.org>
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the names of contributing organizations nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+}}}*/
+
+
+#include "benchmark.h"
+#include "dispatch.h"
+#include <malloc.h>
+#include <Vc/cpuid.h>
+#include <Vc/support.h>
+
+// This translation unit is compiled without architecture flags. The kernels in
+// dispatch_kernels.cpp are compiled once per ISA, and the benchmarks below call them
+// either directly, i.e. an ordinary (not inlined) call into another translation unit
+// without any dispatch, or through one of the runtime dispatch mechanisms.
+
+using PolarFunction = void (*)(const float *, const float *, float *, float *,
+                               std::size_t);
+using QuadSolveFunction = void (*)(const float *, const float *, const float *, float *,
+                                   float *, int *, std::size_t);
+
+///////////////////////////////////////////////////////////////////////////////
+// direct: call the kernel of one ISA by name
+#define Vc_DISPATCH_TARGET(name_, isa_, supported_)                                      \
+  struct name_ {                                                                         \
+    static bool supported() { return supported_; }                                       \
+    static void polar(const float *x, const float *y, float *radius, float *phi,         \
+                      std::size_t n) {                                                   \
+      isa_::polar(x, y, radius, phi, n);                                                 \
+    }                                                                                    \
+    static void quadSolve(const float *a, const float *b, const float *c, float *x1,     \
+                          float *x2, int *roots, std::size_t n) {                        \
+      isa_::quadSolve(a, b, c, x1, x2, roots, n);                                        \
+    }                                                                                    \
+  }
+
+Vc_DISPATCH_TARGET(DirectSSE2, sse2, Vc::isImplementationSupported(Vc::SSE2Impl));
+Vc_DISPATCH_TARGET(DirectSSE42, sse42, Vc::isImplementationSupported(Vc::SSE42Impl) &&
+                                           Vc::CpuId::hasPopcnt());
+Vc_DISPATCH_TARGET(DirectAVX, avx, Vc::isImplementationSupported(Vc::AVXImpl));
+Vc_DISPATCH_TARGET(DirectAVX2, avx2, Vc::isImplementationSupported(Vc::AVX2Impl) &&
+                                         Vc::CpuId::hasFma() && Vc::CpuId::hasBmi2());
+#ifdef Vc_DISPATCH_HAVE_AVX512
+// Vc::CpuId does not know about AVX-512, so ask the compiler runtime instead
+Vc_DISPATCH_TARGET(DirectAVX512, avx512,
+                   DirectAVX2::supported() && __builtin_cpu_supports("avx512f") &&
+                       __builtin_cpu_supports("avx512vl") &&
+                       __builtin_cpu_supports("avx512bw") &&
+                       __builtin_cpu_supports("avx512dq"));
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// function pointers, selected once via Vc::CpuId
+struct Kernels {
+  PolarFunction polar;
+  QuadSolveFunction quadSolve;
+};
+
+template <class Target> Kernels kernelsOf() {
+  return {&Target::polar, &Target::quadSolve};
+}
+
+Kernels bestKernels() {
+  Vc::CpuId::init();
+#ifdef Vc_DISPATCH_HAVE_AVX512
+  if (DirectAVX512::supported()) {
+    return kernelsOf<DirectAVX512>();
+  }
+#endif
+  if (DirectAVX2::supported()) {
+    return kernelsOf<DirectAVX2>();
+  } else if (DirectAVX::supported()) {
+    return kernelsOf<DirectAVX>();
+  } else if (DirectSSE42::supported()) {
+    return kernelsOf<DirectSSE42>();
+  }
+  return kernelsOf<DirectSSE2>();
+}
+
+const Kernels dispatchedKernels = bestKernels();
+
+struct FunctionPointer {
+  static bool supported() { return true; }
+  static void polar(const float *x, const float *y, float *radius, float *phi,
+                    std::size_t n) {
+    dispatchedKernels.polar(x, y, radius, phi, n);
+  }
+  static void quadSolve(const float *a, const float *b, const float *c, float *x1,
+                        float *x2, int *roots, std::size_t n) {
+    dispatchedKernels.quadSolve(a, b, c, x1, x2, roots, n);
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// GNU ifunc: the dynamic linker calls the resolver once and binds the symbol directly.
+// Resolvers run before constructors, so they cannot use Vc::CpuId (which needs init())
+// and use __builtin_cpu_supports instead.
+#if defined(__linux__) && defined(__GNUC__)
+#define Vc_HAVE_IFUNC 1
+template <class F> F resolveIfunc(F fsse2, F fsse42, F favx, F favx2, F favx512) {
+  __builtin_cpu_init();
+  if (favx512 && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl") &&
+      __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512dq")) {
+    return favx512;
+  } else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") &&
+             __builtin_cpu_supports("bmi2")) {
+    return favx2;
+  } else if (__builtin_cpu_supports("avx")) {
+    return favx;
+  } else if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt")) {
+    return fsse42;
+  }
+  return fsse2;
+}
+
+#ifdef Vc_DISPATCH_HAVE_AVX512
+#define Vc_AVX512_KERNEL(name_) &avx512::name_
+#else
+#define Vc_AVX512_KERNEL(name_) nullptr
+#endif
+
+extern "C" {
+PolarFunction vc_benchmark_resolve_polar() {
+  return resolveIfunc<PolarFunction>(&sse2::polar, &sse42::polar, &avx::polar,
+                                     &avx2::polar, Vc_AVX512_KERNEL(polar));
+}
+QuadSolveFunction vc_benchmark_resolve_quadsolve() {
+  return resolveIfunc<QuadSolveFunction>(&sse2::quadSolve, &sse42::quadSolve,
+                                         &avx::quadSolve, &avx2::quadSolve,
+                                         Vc_AVX512_KERNEL(quadSolve));
+}
+}
+
+void polarIfunc(const float *, const float *, float *, float *, std::size_t)
+    __attribute__((ifunc("vc_benchmark_resolve_polar")));
+void quadSolveIfunc(const float *, const float *, const float *, float *, float *,
+                    int *, std::size_t)
+    __attribute__((ifunc("vc_benchmark_resolve_quadsolve")));
+
+struct IFunc {
+  static bool supported() { return true; }
+  static void polar(const float *x, const float *y, float *radius, float *phi,
+                    std::size_t n) {
+    polarIfunc(x, y, radius, phi, n);
+  }
+  static void quadSolve(const float *a, const float *b, const float *c, float *x1,
+                        float *x2, int *roots, std::size_t n) {
+    quadSolveIfunc(a, b, c, x1, x2, roots, n);
+  }
+};
+#endif  // __linux__ && __GNUC__
+
+///////////////////////////////////////////////////////////////////////////////
+// benchmarks
+struct Batch {
+  explicit Batch(std::size_t n_) : n(n_) {
+    unsigned stream = 0;
+    for (float *p : {a, b, c, x, y}) {
+      fillUniform(p, n, -5.f, 5.f, stream++);
+    }
+  }
+
+  ~Batch() {
+    for (void *p : {(void *)a, (void *)b, (void *)c, (void *)x1, (void *)x2,
+                    (void *)roots, (void *)x, (void *)y, (void *)radius, (void *)phi}) {
+      free(p);
+    }
+  }
+
+  Batch(const Batch &) = delete;
+  Batch &operator=(const Batch &) = delete;
+
+  const std::size_t n;
+  float *a = alloc<float>(), *b = alloc<float>(), *c = alloc<float>();
+  float *x1 = alloc<float>(), *x2 = alloc<float>();
+  int *roots = alloc<int>();
+  float *x = alloc<float>(), *y = alloc<float>();
+  float *radius = alloc<float>(), *phi = alloc<float>();
+
+private:
+  template <class T> T *alloc() { return (T *)memalign(64, n * sizeof(T)); }
+};
+
+template <class Target> void polar(benchmark::State &state) {
+  if (!Target::supported()) {
+    state.SkipWithError("ISA not supported by this CPU");
+    return;
+  }
+  Batch d(state.range(0));
+  for (auto _ : state) {
+    Target::polar(d.x, d.y, d.radius, d.phi, d.n);
+    benchmark::ClobberMemory();
+  }
+  state.counters["Items"] = state.iterations() * d.n;
+}
+
+template <class Target> void quadSolve(benchmark::State &state) {
+  if (!Target::supported()) {
+    state.SkipWithError("ISA not supported by this CPU");
+    return;
+  }
+  Batch d(state.range(0));
+  for (auto _ : state) {
+    Target::quadSolve(d.a, d.b, d.c, d.x1, d.x2, d.roots, d.n);
+    benchmark::ClobberMemory();
+  }
+  state.counters["Items"] = state.iterations() * d.n;
+}
+
+//! From batches that fit a single vector, where the call dominates, to large batches
+void batchSizes(benchmark::internal::Benchmark *function) {
+  function->RangeMultiplier(4)->Range(8, 1 << 20);
+}
+
+using Targets = concat<Typelist<DirectSSE2, DirectSSE42, DirectAVX, DirectAVX2>,
+#ifdef Vc_DISPATCH_HAVE_AVX512
+                       Typelist<DirectAVX512>,
+#endif
+#ifdef Vc_HAVE_IFUNC
+                       Typelist<IFunc>,
+#endif
+                       Typelist<FunctionPointer>>;
+
+Vc_BENCHMARK_TEMPLATE(polar, Targets)->Apply(batchSizes);
+Vc_BENCHMARK_TEMPLATE(quadSolve, Targets)->Apply(batchSizes);
@@ -0,0 +1,50 @@
+/*{{{
+Copyright © 2018 Matthias Kretz <kretz@kde.org>
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the names of contributing organizations nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+}}}*/
+
+#ifndef DISPATCH_H
+#define DISPATCH_H
+#include <cstddef>
+
+// Kernels of dispatch.cpp. dispatch_kernels.cpp is compiled once per ISA level into
+// the same executable, each time defining the namespace of that ISA. The kernels are
+// the only global symbols of each ISA build (see CMakeLists.txt).
+#define Vc_DECLARE_DISPATCH_KERNELS(isa_)                                                \
+  namespace isa_ {                                                                       \
+  void polar(const float *x, const float *y, float *radius, float *phi, std::size_t n); \
+  void quadSolve(const float *a, const float *b, const float *c, float *x1, float *x2,   \
+                 int *roots, std::size_t n);                                             \
+  }
+
+Vc_DECLARE_DISPATCH_KERNELS(sse2)
+Vc_DECLARE_DISPATCH_KERNELS(sse42)
+Vc_DECLARE_DISPATCH_KERNELS(avx)
+Vc_DECLARE_DISPATCH_KERNELS(avx2)
+#ifdef Vc_DISPATCH_HAVE_AVX512
+Vc_DECLARE_DISPATCH_KERNELS(avx512)
+#endif
+
+#endif // DISPATCH_H
@@ -0,0 +1,79 @@
+/*{{{
+Copyright © 2018 Matthias Kretz <kretz@kde.org>
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the names of contributing organizations nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+}}}*/
+
+
+#include "dispatch.h"
+#include "mathfunctions.h"
+#include "quadsolve.h"
+
+#ifndef Vc_DISPATCH_ISA
+#error "Vc_DISPATCH_ISA must name the ISA namespace to define (see dispatch.h)"
+#endif
+
+// The same Vc templates are instantiated in every ISA's translation unit. CMakeLists.txt
+// makes every symbol of this object but the kernels local, so that the kernels only
+// call the out-of-line instantiations compiled for their own ISA.
+
+namespace Vc_DISPATCH_ISA {
+void polar(const float *x, const float *y, float *radius, float *phi, std::size_t n) {
+  using V = Vc::float_v;
+  std::size_t i = 0;
+  for (; i + V::size() <= n; i += V::size()) {
+    Coordinate<V> coord;
+    coord.x.load(x + i, Vc::Unaligned);
+    coord.y.load(y + i, Vc::Unaligned);
+    const PolarCoordinate<V> polarCoord = calculatePolarCoordinate(coord);
+    polarCoord.radius.store(radius + i, Vc::Unaligned);
+    polarCoord.phi.store(phi + i, Vc::Unaligned);
+  }
+  for (; i < n; ++i) {
+    const PolarCoordinate<float> polarCoord =
+        calculatePolarCoordinate(Coordinate<float>{x[i], y[i]});
+    radius[i] = polarCoord.radius;
+    phi[i] = polarCoord.phi;
+  }
+}
+
+void quadSolve(const float *a, const float *b, const float *c, float *x1, float *x2,
+               int *roots, std::size_t n) {
+  using Float_v = Vc::float_v;
+  using Int32_v = Vc::SimdArray<int, Float_v::size()>;
+  std::size_t i = 0;
+  for (; i + Float_v::size() <= n; i += Float_v::size()) {
+    Float_v r1(x1 + i, Vc::Unaligned), r2(x2 + i, Vc::Unaligned);
+    Int32_v nroots;
+    QuadSolveSIMD(Float_v(a + i, Vc::Unaligned), Float_v(b + i, Vc::Unaligned),
+                  Float_v(c + i, Vc::Unaligned), r1, r2, nroots);
+    r1.store(x1 + i, Vc::Unaligned);
+    r2.store(x2 + i, Vc::Unaligned);
+    nroots.store(roots + i, Vc::Unaligned);
+  }
+  for (; i < n; ++i) {
+    QuadSolve<float>(a[i], b[i], c[i], x1[i], x2[i], roots[i]);
+  }
+}
+}  // namespace Vc_DISPATCH_ISA
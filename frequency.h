@@ -0,0 +1,263 @@
+/*{{{
+Copyright © 2018 Matthias Kretz <kretz@kde.org>
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the names of contributing organizations nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+}}}*/
+
+#ifndef FREQUENCY_H
+#define FREQUENCY_H
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <vector>
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Effective core frequency of a benchmark thread. Wide vector code can lower the clock
+// (the "AVX license" of x86 cores), which makes per-operation timings of Scalar, SSE
+// and AVX rows incomparable unless the frequency is reported with them. Sources, in
+// order of preference:
+//   perf     CPU cycles against the task clock of the thread (perf_event_open)
+//   APERF    actual cycles from the APERF MSR (/dev/cpu/<n>/msr, usually root only)
+//            against wall time; intervals in which the thread migrated are not
+//            measured
+//   probe    a chain of dependent integer additions (one per cycle) timed right after
+//            the interval. The clock recovers within milliseconds after wide vector
+//            code, so this only approximates the frequency during the interval.
+// report() adds
+//   GHz        effective frequency during the interval
+//   FreqRatio  GHz relative to the frequency of scalar integer code (1: no downclocking)
+
+namespace frequency_detail {
+using clock = std::chrono::steady_clock;
+
+//! Cycles per second of a dependent chain of additions, best of three runs
+inline double probe() {
+  constexpr int N = 1 << 18;
+  double best = std::numeric_limits<double>::max();
+  for (int run = 0; run < 3; ++run) {
+    std::uint64_t x = 0;
+    std::uint64_t one = 1;
+    const auto start = clock::now();
+    for (int i = 0; i < N; ++i) {
+#if defined __x86_64__ || defined __i386__
+      // register operands: recent cores fold chains of additions of immediates
+      asm volatile("add %1, %0\n\tadd %1, %0\n\tadd %1, %0\n\tadd %1, %0\n\t"
+                   "add %1, %0\n\tadd %1, %0\n\tadd %1, %0\n\tadd %1, %0"
+                   : "+r"(x)
+                   : "r"(one));
+#else
+      for (int k = 0; k < 8; ++k) {
+        asm volatile("" : "+r"(x), "+r"(one));
+        x += one;
+      }
+#endif
+    }
+    best = std::min(best, std::chrono::duration<double>(clock::now() - start).count());
+  }
+  return 8. * N / best;
+}
+
+//! Tells once per process that perf cycles are unavailable and which fallback is used
+inline void warnFallbackOnce(const char *source) {
+  static bool warned = false;
+  if (!warned) {
+    warned = true;
+    std::fprintf(stderr,
+                 "perf cycles unavailable; measuring the core frequency with %s (check "
+                 "/proc/sys/kernel/perf_event_paranoid)\n",
+                 source);
+  }
+}
+}  // namespace frequency_detail
+
+class FrequencyMeter {
+public:
+  enum Source { Perf, Aperf, Probe };
+
+  FrequencyMeter() {
+#ifdef __linux__
+    const std::uint64_t events[] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_SW_TASK_CLOCK};
+    const std::uint32_t types[] = {PERF_TYPE_HARDWARE, PERF_TYPE_SOFTWARE};
+    for (int i = 0; i < 2; ++i) {
+      perf_event_attr attr = {};
+      attr.size = sizeof(attr);
+      attr.type = types[i];
+      attr.config = events[i];
+      attr.disabled = i == 0;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP;
+      fds[i] = syscall(__NR_perf_event_open, &attr, 0, -1, fds[0], 0);
+      if (fds[i] < 0) {
+        closeFds();
+        break;
+      }
+    }
+    source_ = fds[0] >= 0 ? Perf : msrFd(0) >= 0 ? Aperf : Probe;
+#else
+    source_ = Probe;
+#endif
+    if (source_ != Perf) {
+      frequency_detail::warnFallbackOnce(source_ == Aperf ? "the APERF MSR"
+                                                          : "a dependent-add probe");
+    }
+  }
+
+  ~FrequencyMeter() { closeFds(); }
+
+  FrequencyMeter(const FrequencyMeter &) = delete;
+  FrequencyMeter &operator=(const FrequencyMeter &) = delete;
+
+  Source source() const { return source_; }
+
+  void start() {
+    hz = 0;
+#ifdef __linux__
+    if (source_ == Perf) {
+      ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+      ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    } else if (source_ == Aperf) {
+      cpu = sched_getcpu();
+      aperf = readAperf(cpu);
+    }
+#endif
+    startTime = frequency_detail::clock::now();
+  }
+
+  void stop() {
+    const double seconds =
+        std::chrono::duration<double>(frequency_detail::clock::now() - startTime).count();
+#ifdef __linux__
+    if (source_ == Perf) {
+      ioctl(fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+      // layout for PERF_FORMAT_GROUP: nr, value[nr]
+      std::uint64_t buf[3] = {};
+      if (read(fds[0], buf, sizeof(buf)) == sizeof(buf) && buf[2] > 0) {
+        hz = buf[1] * 1e9 / buf[2];
+      }
+      return;
+    }
+    if (source_ == Aperf) {
+      if (sched_getcpu() == cpu && aperf > 0 && seconds > 0) {
+        hz = (readAperf(cpu) - aperf) / seconds;
+      }
+      return;
+    }
+#endif
+    (void)seconds;
+    hz = frequency_detail::probe();
+  }
+
+  //! Frequency in Hz of the last start()/stop() interval, 0 if it could not be measured
+  double frequency() const { return hz; }
+
+  //! The frequency of scalar integer code, measured once per process with the same
+  //! source. Call it before the first benchmark runs: right after wide vector code the
+  //! core may still run at the lower clock.
+  static double scalarFrequency() {
+    static const double f = [] {
+      FrequencyMeter meter;
+      meter.start();
+      frequency_detail::probe();
+      meter.stop();
+      return meter.frequency();
+    }();
+    return f;
+  }
+
+  void report(benchmark::State &state) const {
+    if (hz <= 0) {
+      return;
+    }
+    state.counters["GHz"] = benchmark::Counter(hz * 1e-9, benchmark::Counter::kAvgThreads);
+    const double scalar = scalarFrequency();
+    if (scalar > 0) {
+      state.counters["FreqRatio"] =
+          benchmark::Counter(hz / scalar, benchmark::Counter::kAvgThreads);
+    }
+  }
+
+private:
+  void closeFds() {
+#ifdef __linux__
+    for (int &fd : fds) {
+      if (fd >= 0) {
+        close(fd);
+      }
+      fd = -1;
+    }
+#endif
+  }
+
+#ifdef __linux__
+  //! The msr device of the given CPU, opened once per process (-1 if unavailable)
+  static int msrFd(int cpu) {
+    static std::vector<int> devices;
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (cpu < 0) {
+      return -1;
+    }
+    if (devices.size() <= std::size_t(cpu)) {
+      devices.resize(cpu + 1, -2);
+    }
+    if (devices[cpu] == -2) {
+      devices[cpu] = open(("/dev/cpu/" + std::to_string(cpu) + "/msr").c_str(), O_RDONLY);
+    }
+    return devices[cpu];
+  }
+
+  static std::uint64_t readAperf(int cpu) {
+    constexpr off_t IA32_APERF = 0xe8;
+    std::uint64_t value = 0;
+    const int fd = msrFd(cpu);
+    if (fd < 0 || pread(fd, &value, sizeof(value), IA32_APERF) != sizeof(value)) {
+      return 0;
+    }
+    return value;
+  }
+
+  int fds[2] = {-1, -1};
+  int cpu = -1;
+  std::uint64_t aperf = 0;
+#endif
+  Source source_;
+  frequency_detail::clock::time_point startTime;
+  double hz = 0;
+};
+
+#endif // FREQUENCY_H
@@ -0,0 +1,198 @@
+/*{{{
+Copyright © 2018 Matthias Kretz <kretz@kde.org>
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the names of contributing organizations nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+}}}*/
+
+
+#include "benchmark.h"
+#include <algorithm>
+#include <random>
+
+// The number of table accesses per benchmark iteration is the table size, but at least
+// MinAccesses, so that every pattern spreads over the whole table.
+constexpr std::size_t MinAccesses = 16 * 1024;
+
+using IndexContainer = std::vector<int, Vc::Allocator<int>>;
+
+///////////////////////////////////////////////////////////////////////////////
+// index patterns
+//
+// Each pattern fills the index array for a table of tableSize elements. lanes is the
+// width of the vector that consumes the indexes, so that patterns can be defined per
+// gather/scatter instruction.
+
+//! i * S: S = 1 is contiguous, larger strides touch more cache lines per gather. Every
+//! pass over the table starts one element further, so that S passes cover all of it.
+template <int S> struct Stride {
+  static void fill(IndexContainer &indexes, std::size_t tableSize, std::size_t,
+                   std::size_t) {
+    for (std::size_t i = 0; i < indexes.size(); ++i) {
+      const std::size_t pass = i * S / tableSize;
+      indexes[i] = (i * S + pass) % tableSize;
+    }
+  }
+};
+
+//! uniformly distributed over the whole table
+struct Random {
+  static void fill(IndexContainer &indexes, std::size_t tableSize, std::size_t,
+                   std::size_t) {
+    std::mt19937 engine;
+    std::uniform_int_distribution<int> dist(0, tableSize - 1);
+    for (auto &i : indexes) {
+      i = dist(engine);
+    }
+  }
+};
+
+//! all indexes of one gather/scatter hit the same randomly chosen block of Bytes
+template <std::size_t Bytes> struct Clustered {
+  static void fill(IndexContainer &indexes, std::size_t tableSize, std::size_t lanes,
+                   std::size_t elementSize) {
+    const std::size_t blockSize =
+        std::min(std::max<std::size_t>(Bytes / elementSize, 1), tableSize);
+    std::mt19937 engine;
+    std::uniform_int_distribution<int> block(0, tableSize / blockSize - 1);
+    std::uniform_int_distribution<int> offset(0, blockSize - 1);
+    for (std::size_t i = 0; i < indexes.size(); i += lanes) {
+      const int base = block(engine) * blockSize;
+      for (std::size_t m = 0; m < lanes; ++m) {
+        indexes[i + m] = base + offset(engine);
+      }
+    }
+  }
+};
+
+using ClusteredCacheLine = Clustered<64>;
+using ClusteredPage = Clustered<4096>;
+
+//! every index of a gather/scatter occurs twice (lane m uses base + m / 2)
+struct Conflicting {
+  static void fill(IndexContainer &indexes, std::size_t tableSize, std::size_t lanes,
+                   std::size_t) {
+    std::mt19937 engine;
+    std::uniform_int_distribution<int> dist(0, tableSize - 1);
+    for (std::size_t i = 0; i < indexes.size(); i += lanes) {
+      const int base = dist(engine);
+      for (std::size_t m = 0; m < lanes; ++m) {
+        indexes[i + m] = (base + m / 2) % tableSize;
+      }
+    }
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// access methods
+struct GatherScatter {};
+struct ScalarLoop {};
+
+struct Read {};
+struct Write {};
+
+template <class V>
+inline V gather(const typename V::EntryType *table, const int *indexes, GatherScatter) {
+  return V(table, typename V::IndexType(indexes, Vc::Unaligned));
+}
+
+template <class V>
+inline V gather(const typename V::EntryType *table, const int *indexes, ScalarLoop) {
+  V r;
+  for (std::size_t m = 0; m < V::size(); ++m) {
+    r[m] = table[indexes[m]];
+  }
+  return r;
+}
+
+template <class V>
+inline void scatter(typename V::EntryType *table, const int *indexes, const V &x,
+                    GatherScatter) {
+  x.scatter(table, typename V::IndexType(indexes, Vc::Unaligned));
+}
+
+template <class V>
+inline void scatter(typename V::EntryType *table, const int *indexes, const V &x,
+                    ScalarLoop) {
+  for (std::size_t m = 0; m < V::size(); ++m) {
+    table[indexes[m]] = x[m];
+  }
+}
+
+template <class V, class Method>
+void access(benchmark::State &state, typename V::EntryType *table, const int *indexes,
+            std::size_t accesses, Read, Method) {
+  V sum = V::Zero();
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < accesses; i += V::size()) {
+      sum += gather<V>(table, &indexes[i], Method());
+    }
+    do_not_optimize(sum);
+  }
+}
+
+template <class V, class Method>
+void access(benchmark::State &state, typename V::EntryType *table, const int *indexes,
+            std::size_t accesses, Write, Method) {
+  V x = V::IndexesFromZero();
+  for (auto _ : state) {
+    fake_modification(x);
+    for (std::size_t i = 0; i < accesses; i += V::size()) {
+      scatter(table, &indexes[i], x, Method());
+    }
+    benchmark::ClobberMemory();
+  }
+}
+
+template <class Config> void gatherScatter(benchmark::State &state) {
+  using Pattern = typename Config::template at<0>;
+  using Direction = typename Config::template at<1>;
+  using Method = typename Config::template at<2>;
+  using V = typename Config::template at<3>;
+  using T = typename V::EntryType;
+
+  const std::size_t tableSize = std::max<std::size_t>(state.range(0) / sizeof(T), 1);
+  std::vector<T, Vc::Allocator<T>> table(tableSize, T(1));
+  const std::size_t accesses =
+      (std::max(tableSize, MinAccesses) + V::size() - 1) / V::size() * V::size();
+  IndexContainer indexes(accesses);
+  Pattern::fill(indexes, tableSize, V::size(), sizeof(T));
+
+  access<V>(state, table.data(), indexes.data(), accesses, Direction(), Method());
+
+  const double items = state.iterations() * accesses;
+  state.counters["Items"] = items;
+  state.counters["Bytes"] = items * sizeof(T);
+  labelCacheLevel(state, tableSize * sizeof(T));
+}
+
+Vc_BENCHMARK_TEMPLATE(
+    gatherScatter,
+    outer_product<
+        Typelist<Stride<1>, Stride<2>, Stride<4>, Stride<8>, Stride<16>, Stride<32>,
+                 Stride<64>, Random, ClusteredCacheLine, ClusteredPage, Conflicting>,
+        outer_product<Typelist<Read, Write>,
+                      outer_product<Typelist<GatherScatter, ScalarLoop>,
+                                    concat<all_vectors_of<float>, all_vectors_of<double>,
+                                           all_vectors_of<int>>>>>)
+    ->Apply(cacheSweepOf<1>);
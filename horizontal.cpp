@@ -0,0 +1,171 @@
+/*{{{
+Copyright © 2018 Matthias Kretz <kretz@kde.org>
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the names of contributing organizations nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+}}}*/
+
+
+#include "benchmark.h"
+
+// Throughput: four independent inputs per iteration, so the operations can overlap.
+// Latency: the result is fed back as the next input, so every operation waits for the
+// previous one.
+struct Throughput {};
+struct Latency {};
+
+struct NativeInput {
+  template <class V> using input = V;
+};
+
+struct Sum : NativeInput {
+  template <class V> static typename V::EntryType apply(const V &x, const V &) {
+    return x.sum();
+  }
+};
+
+struct Product : NativeInput {
+  template <class V> static typename V::EntryType apply(const V &x, const V &) {
+    return x.product();
+  }
+};
+
+struct Min : NativeInput {
+  template <class V> static typename V::EntryType apply(const V &x, const V &) {
+    return x.min();
+  }
+};
+
+struct Max : NativeInput {
+  template <class V> static typename V::EntryType apply(const V &x, const V &) {
+    return x.max();
+  }
+};
+
+struct PartialSum : NativeInput {
+  template <class V> static V apply(const V &x, const V &) { return x.partialSum(); }
+};
+
+struct Rotated : NativeInput {
+  template <class V> static V apply(const V &x, const V &) { return x.rotated(1); }
+};
+
+struct Shifted : NativeInput {
+  template <class V> static V apply(const V &x, const V &) { return x.shifted(1); }
+};
+
+struct Reversed : NativeInput {
+  template <class V> static V apply(const V &x, const V &) { return x.reversed(); }
+};
+
+struct Sorted : NativeInput {
+  template <class V> static V apply(const V &x, const V &) { return x.sorted(); }
+};
+
+struct InterleaveLow : NativeInput {
+  template <class V> static V apply(const V &x, const V &y) {
+    return x.interleaveLow(y);
+  }
+};
+
+struct InterleaveHigh : NativeInput {
+  template <class V> static V apply(const V &x, const V &y) {
+    return x.interleaveHigh(y);
+  }
+};
+
+template <class V> using Twice = Vc::SimdArray<typename V::EntryType, 2 * V::size()>;
+
+struct SimdCastMerge : NativeInput {
+  template <class V> static Twice<V> apply(const V &x, const V &y) {
+    return Vc::simd_cast<Twice<V>>(x, y);
+  }
+};
+
+struct SimdCastSplit {
+  template <class V> using input = Twice<V>;
+
+  template <class V> static V apply(const Twice<V> &x, const Twice<V> &) {
+    return Vc::simd_cast<V, 1>(x);
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// feedback<I>(result): turn the result of an operation into the next input
+template <class I, class R>
+inline typename std::enable_if<Vc::is_simd_vector<R>::value, I>::type feedback(
+    const R &r) {
+  return Vc::simd_cast<I>(r);
+}
+template <class I, class R>
+inline typename std::enable_if<!Vc::is_simd_vector<R>::value, I>::type feedback(
+    const R &r) {
+  return I(r);
+}
+
+template <class Op, class V> void run(benchmark::State &state, Throughput) {
+  using I = typename Op::template input<V>;
+
+  I a = I::Random(), b = I::Random(), c = I::Random(), d = I::Random();
+
+  for (auto _ : state) {
+    fake_modification(a);
+    fake_modification(b);
+    fake_modification(c);
+    fake_modification(d);
+    do_not_optimize(Op::template apply<V>(a, b));
+    do_not_optimize(Op::template apply<V>(b, c));
+    do_not_optimize(Op::template apply<V>(c, d));
+    do_not_optimize(Op::template apply<V>(d, a));
+  }
+  state.counters["Rate"] = state.iterations() * 4;
+}
+
+template <class Op, class V> void run(benchmark::State &state, Latency) {
+  using I = typename Op::template input<V>;
+
+  I x = I::Random(), y = I::Random();
+
+  for (auto _ : state) {
+    fake_modification(y);
+    x = feedback<I>(Op::template apply<V>(x, y));
+    fake_modification(x);
+  }
+  do_not_optimize(x);
+  state.counters["Rate"] = state.iterations();
+}
+
+template <class Config> void horizontal(benchmark::State &state) {
+  using Op = typename Config::template at<0>;
+  using Mode = typename Config::template at<1>;
+  using V = typename Config::template at<2>;
+
+  run<Op, V>(state, Mode());
+}
+
+Vc_BENCHMARK_TEMPLATE(
+    horizontal,
+    outer_product<Typelist<Sum, Product, Min, Max, PartialSum, Rotated, Shifted, Reversed,
+                           Sorted, InterleaveLow, InterleaveHigh, SimdCastMerge,
+                           SimdCastSplit>,
+                  outer_product<Typelist<Throughput, Latency>, all_vectors>>);
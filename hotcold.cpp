@@ -0,0 +1,210 @@
+/*{{{
+Copyright © 2018 Matthias Kretz <kretz@kde.org>
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the names of contributing organizations nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+}}}*/
+
+
+#include "benchmark.h"
+#include "perfcounters.h"
+#include "roofline.h"
+#include <algorithm>
+#include <vector>
+
+// Wide records of which the kernel only reads a few ("hot") fields: how much of the
+// fetched memory each layout actually uses. The argument is the size of all records in
+// bytes. Reports per iteration
+//   UsedBytes         bytes of the hot fields
+//   FetchedBytes      bytes of all cache lines that contain hot fields
+//   Efficiency        UsedBytes / FetchedBytes
+//   PerfFetchedBytes  L1D misses * 64, if hardware counters are available
+// and the roofline counters (see roofline.h) of one addition per hot field and the
+// fetched bytes.
+
+//! Records of Fields members, of which the kernel reads the first Hot
+template <int Fields, int Hot> struct Shape {
+  static_assert(Hot > 0 && Hot <= Fields, "invalid Shape");
+  static constexpr int fields = Fields;
+  static constexpr int hot = Hot;
+};
+
+constexpr std::size_t CacheLine = 64;
+
+//! Counts the cache lines of address ranges that are touched in increasing order
+class LineCounter {
+public:
+  void touch(const void *p, std::size_t bytes) {
+    const std::size_t first = reinterpret_cast<std::uintptr_t>(p) / CacheLine;
+    const std::size_t last = (reinterpret_cast<std::uintptr_t>(p) + bytes - 1) / CacheLine;
+    lines += last - first + 1 - (first == previous ? 1 : 0);
+    previous = last;
+  }
+  std::size_t bytes() const { return lines * CacheLine; }
+
+private:
+  std::size_t lines = 0;
+  std::size_t previous = std::size_t(-1);
+};
+
+template <class T> using Array = std::vector<T, FirstTouchAllocator<T>>;
+
+///////////////////////////////////////////////////////////////////////////////
+// layouts
+//
+// load(i, k) returns field k of the records i, ..., i + V::size() - 1.
+
+//! All fields of a record next to each other
+struct Aos {
+  template <class V, class S> struct type {
+    using T = typename V::EntryType;
+    Array<T> data;
+    const typename V::IndexType stride = V::IndexType::IndexesFromZero() * S::fields;
+
+    explicit type(std::size_t n) : data(n * S::fields) {
+      fillUniform(data.data(), data.size(), T(0), T(1));
+    }
+    V load(std::size_t i, int k) const { return V(&data[i * S::fields + k], stride); }
+    std::size_t fetchedBytes(std::size_t n) const {
+      LineCounter lines;
+      for (std::size_t r = 0; r < n; ++r) {
+        lines.touch(&data[r * S::fields], S::hot * sizeof(T));
+      }
+      return lines.bytes();
+    }
+  };
+};
+
+//! One array per field
+struct Soa {
+  template <class V, class S> struct type {
+    using T = typename V::EntryType;
+    std::vector<Array<T>> data;
+
+    explicit type(std::size_t n) : data(S::fields) {
+      for (int k = 0; k < S::fields; ++k) {
+        data[k].resize(n);
+        fillUniform(data[k].data(), n, T(0), T(1), k);
+      }
+    }
+    V load(std::size_t i, int k) const { return V(&data[k][i], Vc::Aligned); }
+    std::size_t fetchedBytes(std::size_t n) const {
+      std::size_t bytes = 0;
+      for (int k = 0; k < S::hot; ++k) {
+        LineCounter lines;
+        lines.touch(data[k].data(), n * sizeof(T));
+        bytes += lines.bytes();
+      }
+      return bytes;
+    }
+  };
+};
+
+//! Blocks of V::size() records, one vector per field
+struct Aosoa {
+  template <class V, class S> struct type {
+    using T = typename V::EntryType;
+    static constexpr std::size_t W = V::size();
+    Array<T> data;
+
+    explicit type(std::size_t n) : data(n * S::fields) {
+      fillUniform(data.data(), data.size(), T(0), T(1));
+    }
+    V load(std::size_t i, int k) const {
+      return V(&data[i * S::fields + k * W], Vc::Aligned);
+    }
+    std::size_t fetchedBytes(std::size_t n) const {
+      LineCounter lines;
+      for (std::size_t i = 0; i < n; i += W) {
+        lines.touch(&data[i * S::fields], S::hot * W * sizeof(T));
+      }
+      return lines.bytes();
+    }
+  };
+};
+
+//! The hot fields of all records in one array (as AoS), the cold fields in another
+struct HotCold {
+  template <class V, class S> struct type {
+    using T = typename V::EntryType;
+    Array<T> hot;
+    Array<T> cold;
+    const typename V::IndexType stride = V::IndexType::IndexesFromZero() * S::hot;
+
+    explicit type(std::size_t n) : hot(n * S::hot), cold(n * (S::fields - S::hot)) {
+      fillUniform(hot.data(), hot.size(), T(0), T(1), 0);
+      fillUniform(cold.data(), cold.size(), T(0), T(1), 1);
+    }
+    V load(std::size_t i, int k) const { return V(&hot[i * S::hot + k], stride); }
+    std::size_t fetchedBytes(std::size_t n) const {
+      LineCounter lines;
+      lines.touch(hot.data(), n * S::hot * sizeof(T));
+      return lines.bytes();
+    }
+  };
+};
+
+template <class Config> void hotCold(benchmark::State &state) {
+  using S = typename Config::template at<0>;
+  using Layout = typename Config::template at<1>;
+  using V = typename Config::template at<2>;
+  using T = typename V::EntryType;
+
+  constexpr std::size_t RecordSize = S::fields * sizeof(T);
+  const std::size_t n =
+      std::max<std::size_t>(state.range(0) / RecordSize / V::size(), 1) * V::size();
+  const typename Layout::template type<V, S> data(n);
+
+  PerfCounters perf;
+  perf.start();
+  for (auto _ : state) {
+    V sum = V::Zero();
+    for (std::size_t i = 0; i < n; i += V::size()) {
+      for (int k = 0; k < S::hot; ++k) {
+        sum += data.load(i, k);
+      }
+    }
+    do_not_optimize(sum);
+  }
+  perf.stop();
+  perf.report(state);
+
+  const double used = n * S::hot * sizeof(T);
+  const double fetched = data.fetchedBytes(n);
+  reportRoofline<V>(state, double(state.iterations()) * n, S::hot, fetched / n,
+                    n * RecordSize);
+  state.counters["UsedBytes"] = used;
+  state.counters["FetchedBytes"] = fetched;
+  state.counters["Efficiency"] = used / fetched;
+  const auto l1dMisses = state.counters.find("L1DMisses");
+  if (l1dMisses != state.counters.end()) {
+    state.counters["PerfFetchedBytes"] = l1dMisses->second.value * CacheLine;
+  }
+}
+
+Vc_BENCHMARK_TEMPLATE(
+    hotCold,
+    outer_product<Typelist<Shape<10, 1>, Shape<10, 2>, Shape<10, 4>, Shape<20, 1>,
+                           Shape<20, 2>, Shape<20, 4>>,
+                  outer_product<Typelist<Aos, Soa, Aosoa, HotCold>, all_real_vectors>>)
+    ->Apply(cacheSweepOf<1>);
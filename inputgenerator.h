@@ -0,0 +1,269 @@
+/*{{{
+Copyright © 2018 Matthias Kretz <kretz@kde.org>
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the names of contributing organizations nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+}}}*/
+
+
+#ifndef INPUTGENERATOR_H
+#define INPUTGENERATOR_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <Vc/Vc>
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Benchmark inputs. Every value is a function of (seed, stream, index) only, so any number
+// of threads can fill any part of an array and the data is the same in every run with the
+// same --seed. The generator hashes the index with a 32-bit integer bijection, on
+// SimdArray<unsigned> for the bulk of an array.
+// With --corpus=<dir>, fillUniform additionally keeps every array it generates as a flat
+// binary file in <dir>, named after generator, seed, stream, type, size and range. Later
+// runs map that file read-only and copy it instead of generating the array again.
+
+//! The seed of all inputs, set with --seed=<n> (default 0)
+inline std::uint64_t &inputSeed() {
+  static std::uint64_t seed = 0;
+  return seed;
+}
+
+//! The directory of the input corpus, set with --corpus=<dir>; empty disables the corpus
+inline std::string &inputCorpus() {
+  static std::string dir;
+  return dir;
+}
+
+//! Removes --seed=<n> and --corpus=<dir> from argv, sets inputSeed() and inputCorpus()
+//! and returns the new argc
+inline int parseInputFlags(int argc, char **argv) {
+  int out = 1;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strncmp(argv[i], "--seed=", 7) == 0) {
+      inputSeed() = std::strtoull(argv[i] + 7, nullptr, 0);
+    } else if (std::strncmp(argv[i], "--corpus=", 9) == 0) {
+      inputCorpus() = argv[i] + 9;
+    } else {
+      argv[out++] = argv[i];
+    }
+  }
+  argv[out] = nullptr;
+  return out;
+}
+
+namespace input_detail {
+// "lowbias32" from Chris Wellons' hash prospector
+template <class U> U hash(U x) {
+  x ^= x >> 16;
+  x *= 0x7feb352du;
+  x ^= x >> 15;
+  x *= 0x846ca68bu;
+  x ^= x >> 16;
+  return x;
+}
+
+inline unsigned key(unsigned stream) {
+  const std::uint64_t seed = inputSeed();
+  return hash(unsigned(seed) ^ hash(unsigned(seed >> 32) ^ hash(stream + 0x9e3779b9u)));
+}
+
+template <class U> U bits(U index, unsigned key) { return hash(hash(index ^ key) + key); }
+}  // namespace input_detail
+
+//! Calls f(begin, end) for disjoint ranges that cover [0, n), from several threads. All
+//! ranges but the last have a multiple of Granularity elements.
+template <std::size_t Granularity = 1, class F> void parallelFor(std::size_t n, F &&f) {
+  constexpr std::size_t MinChunk = std::size_t(1) << 16;
+  const std::size_t threads = std::max<std::size_t>(
+      1, std::min<std::size_t>(std::thread::hardware_concurrency(), n / MinChunk));
+  const std::size_t perThread = (n + threads - 1) / threads;
+  const std::size_t chunk = (perThread + Granularity - 1) / Granularity * Granularity;
+  std::vector<std::thread> workers;
+  for (std::size_t t = 1; t < threads; ++t) {
+    const std::size_t begin = std::min(n, t * chunk);
+    const std::size_t end = std::min(n, begin + chunk);
+    workers.emplace_back([&f, begin, end] { f(begin, end); });
+  }
+  f(0, std::min(n, chunk));
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+namespace input_detail {
+// Bump when the values generated for a given key change.
+constexpr int GeneratorVersion = 1;
+
+template <class T>
+std::string corpusPath(std::size_t n, T lo, T hi, unsigned stream) {
+  char name[256];
+  std::snprintf(name, sizeof(name), "/uniform%d_seed%llx_stream%u_f%zu_n%zu_%a_%a.bin",
+                GeneratorVersion, static_cast<unsigned long long>(inputSeed()), stream,
+                8 * sizeof(T), n, double(lo), double(hi));
+  return inputCorpus() + name;
+}
+
+//! Copies the file at path into data if it holds exactly bytes bytes
+inline bool loadCorpus(const std::string &path, void *data, std::size_t bytes) {
+#ifdef __linux__
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || std::size_t(info.st_size) != bytes || bytes == 0) {
+    close(fd);
+    return false;
+  }
+  void *file = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+  close(fd);
+  if (file == MAP_FAILED) {
+    return false;
+  }
+  madvise(file, bytes, MADV_SEQUENTIAL);
+  // the copying threads place the pages of data, as fillUniform would have
+  parallelFor<4096>(bytes, [&](std::size_t begin, std::size_t end) {
+    std::memcpy(static_cast<char *>(data) + begin, static_cast<const char *>(file) + begin,
+                end - begin);
+  });
+  munmap(file, bytes);
+  return true;
+#else
+  return false;
+#endif
+}
+
+//! Writes data to path; via a temporary file, so that concurrent runs never see a
+//! partial corpus file
+inline void storeCorpus(const std::string &path, const void *data, std::size_t bytes) {
+#ifdef __linux__
+  const std::string tmp = path + ".tmp" + std::to_string(getpid());
+  const int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    return;
+  }
+  const char *p = static_cast<const char *>(data);
+  std::size_t left = bytes;
+  while (left > 0) {
+    const ssize_t written = write(fd, p, left);
+    if (written <= 0) {
+      break;
+    }
+    p += written;
+    left -= written;
+  }
+  close(fd);
+  if (left != 0 || rename(tmp.c_str(), path.c_str()) != 0) {
+    unlink(tmp.c_str());
+  }
+#endif
+}
+}  // namespace input_detail
+
+//! Value number index of the given stream, uniformly distributed in [lo, hi)
+template <class T> T uniformAt(std::size_t index, T lo, T hi, unsigned stream = 0) {
+  static_assert(std::is_floating_point<T>::value, "uniformAt requires a floating-point T");
+  const unsigned bits = input_detail::bits(unsigned(index), input_detail::key(stream));
+  return lo + T(bits >> 8) * ((hi - lo) / T(1 << 24));
+}
+
+//! Sets data[i] = uniformAt(i, lo, hi, stream) for all i < n, in parallel (or copies them
+//! from the corpus). Each thread writes its part first, so on fresh memory the pages are
+//! local to that thread.
+template <class T>
+void fillUniform(T *data, std::size_t n, T lo, T hi, unsigned stream = 0) {
+  static_assert(std::is_floating_point<T>::value, "fillUniform requires a floating-point T");
+  std::string corpusPath;
+  if (!inputCorpus().empty()) {
+    corpusPath = input_detail::corpusPath(n, lo, hi, stream);
+    if (input_detail::loadCorpus(corpusPath, data, n * sizeof(T))) {
+      return;
+    }
+  }
+  using V = Vc::SimdArray<T, Vc::Vector<T>::size()>;
+  using U = Vc::SimdArray<unsigned, V::size()>;
+  const unsigned key = input_detail::key(stream);
+  const T scale = (hi - lo) / T(1 << 24);
+  parallelFor<V::size()>(n, [&](std::size_t begin, std::size_t end) {
+    std::size_t i = begin;
+    for (; i + V::size() <= end; i += V::size()) {
+      const U bits = input_detail::bits(U::IndexesFromZero() + unsigned(i), key);
+      const V x = lo + Vc::simd_cast<V>(bits >> 8) * scale;
+      x.store(&data[i], Vc::Unaligned);
+    }
+    for (; i < end; ++i) {
+      data[i] = lo + T(input_detail::bits(unsigned(i), key) >> 8) * scale;
+    }
+  });
+  if (!corpusPath.empty()) {
+    input_detail::storeCorpus(corpusPath, data, n * sizeof(T));
+  }
+}
+
+//! Sets data[i] to the 32 random bits of index i of the given stream (uniformly
+//! distributed over all values of T), in parallel like fillUniform. Not kept in the
+//! corpus: generating is as fast as copying.
+template <class T> void fillBits(T *data, std::size_t n, unsigned stream = 0) {
+  static_assert(std::is_integral<T>::value && sizeof(T) == sizeof(unsigned),
+                "fillBits requires a 32-bit integral T");
+  const unsigned key = input_detail::key(stream);
+  parallelFor(n, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+      data[i] = T(input_detail::bits(unsigned(i), key));
+    }
+  });
+}
+
+//! Vc::Allocator that default-initializes instead of value-initializing, so that vectors
+//! of trivial types are not written (and their pages not touched) until fillUniform.
+//! Only for inputs that fillUniform writes: any other array would take its page faults
+//! in the first measured iterations.
+template <class T> struct FirstTouchAllocator : Vc::Allocator<T> {
+  template <class U> struct rebind {
+    using other = FirstTouchAllocator<U>;
+  };
+
+  FirstTouchAllocator() = default;
+  template <class U> FirstTouchAllocator(const FirstTouchAllocator<U> &) {}
+
+  template <class U> void construct(U *p) { ::new (static_cast<void *>(p)) U; }
+  template <class U, class... Args> void construct(U *p, Args &&... args) {
+    ::new (static_cast<void *>(p)) U(std::forward<Args>(args)...);
+  }
+};
+
+#endif  // INPUTGENERATOR_H
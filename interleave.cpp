@@ -0,0 +1,177 @@
+/*{{{
+Copyright © 2018 Matthias Kretz <kretz@kde.org>
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the names of contributing organizations nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+}}}*/
+
+
+#include "benchmark.h"
+#include <utility>
+
+// Load/store cost of records with N members of T: deinterleaving with Vc's
+// InterleavedMemoryWrapper and Vc::tie, against element-wise subscripts and strided
+// gather/scatter.
+
+// bytes of records per benchmark iteration, the same for every T and N (L1 or L2)
+constexpr std::size_t RecordBytes = 32 * 1024;
+
+//! Number of records of N members of T in RecordBytes, a multiple of V::size()
+template <class V, int N> constexpr std::size_t recordCount() {
+  return RecordBytes / (N * sizeof(typename V::EntryType)) / V::size() * V::size();
+}
+
+//! A record of N members, like xyz (3), xyzw (4) or a pose (6)
+template <class T, int N> struct Record {
+  T m[N];
+};
+
+template <int N> using Members = std::integral_constant<int, N>;
+
+///////////////////////////////////////////////////////////////////////////////
+// access methods
+//
+// x[k] holds member k of the records i, ..., i + V::size() - 1.
+struct Interleaved {};
+struct ScalarSubscript {};
+struct GatherScatter {};
+
+struct Read {};
+struct Write {};
+
+template <class V, class R, std::size_t... Ks>
+inline void load(R *data, std::size_t i, V *x, Interleaved, std::index_sequence<Ks...>) {
+  Vc::Common::InterleavedMemoryWrapper<R, V> wrapper(data);
+  Vc::tie(x[Ks]...) = wrapper[i];
+}
+
+template <class V, class R, std::size_t... Ks>
+inline void store(R *data, std::size_t i, const V *x, Interleaved,
+                  std::index_sequence<Ks...>) {
+  Vc::Common::InterleavedMemoryWrapper<R, V> wrapper(data);
+  wrapper[i] = Vc::tie(x[Ks]...);
+}
+
+template <class V, class R, std::size_t... Ks>
+inline void load(R *data, std::size_t i, V *x, ScalarSubscript,
+                 std::index_sequence<Ks...>) {
+  for (std::size_t m = 0; m < V::size(); ++m) {
+    for (std::size_t k = 0; k < sizeof...(Ks); ++k) {
+      x[k][m] = data[i + m].m[k];
+    }
+  }
+}
+
+template <class V, class R, std::size_t... Ks>
+inline void store(R *data, std::size_t i, const V *x, ScalarSubscript,
+                  std::index_sequence<Ks...>) {
+  for (std::size_t m = 0; m < V::size(); ++m) {
+    for (std::size_t k = 0; k < sizeof...(Ks); ++k) {
+      data[i + m].m[k] = x[k][m];
+    }
+  }
+}
+
+template <class V, std::size_t N>
+inline typename V::IndexType recordIndexes(std::size_t i) {
+  using IT = typename V::IndexType;
+  return (IT::IndexesFromZero() + int(i)) * int(N);
+}
+
+template <class V, class R, std::size_t... Ks>
+inline void load(R *data, std::size_t i, V *x, GatherScatter,
+                 std::index_sequence<Ks...>) {
+  const auto indexes = recordIndexes<V, sizeof...(Ks)>(i);
+  for (std::size_t k = 0; k < sizeof...(Ks); ++k) {
+    x[k] = V(&data->m[k], indexes);
+  }
+}
+
+template <class V, class R, std::size_t... Ks>
+inline void store(R *data, std::size_t i, const V *x, GatherScatter,
+                  std::index_sequence<Ks...>) {
+  const auto indexes = recordIndexes<V, sizeof...(Ks)>(i);
+  for (std::size_t k = 0; k < sizeof...(Ks); ++k) {
+    x[k].scatter(&data->m[k], indexes);
+  }
+}
+
+template <class V, class R, class Method, class Ks>
+void access(benchmark::State &state, R *data, std::size_t records, V *x, Read, Method,
+            Ks) {
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < records; i += V::size()) {
+      load(data, i, x, Method(), Ks());
+      for (std::size_t k = 0; k < Ks::size(); ++k) {
+        do_not_optimize(x[k]);
+      }
+    }
+  }
+}
+
+template <class V, class R, class Method, class Ks>
+void access(benchmark::State &state, R *data, std::size_t records, V *x, Write, Method,
+            Ks) {
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < records; i += V::size()) {
+      for (std::size_t k = 0; k < Ks::size(); ++k) {
+        fake_modification(x[k]);
+      }
+      store(data, i, x, Method(), Ks());
+    }
+    benchmark::ClobberMemory();
+  }
+}
+
+template <class Config> void interleave(benchmark::State &state) {
+  using N = typename Config::template at<0>;
+  using Direction = typename Config::template at<1>;
+  using Method = typename Config::template at<2>;
+  using V = typename Config::template at<3>;
+  using T = typename V::EntryType;
+  using R = Record<T, N::value>;
+  constexpr std::size_t Records = recordCount<V, N::value>();
+
+  std::vector<R, Vc::Allocator<R>> data(Records);
+  fillUniform(&data[0].m[0], Records * N::value, T(0), T(1));
+  V x[N::value];
+  for (auto &v : x) {
+    v = V::IndexesFromZero();
+  }
+
+  access<V>(state, data.data(), Records, x, Direction(), Method(),
+            std::make_index_sequence<N::value>());
+
+  const double items = state.iterations() * Records;
+  state.counters["Items"] = items;
+  state.counters["Bytes"] = items * sizeof(R);
+}
+
+Vc_BENCHMARK_TEMPLATE(
+    interleave,
+    outer_product<
+        Typelist<Members<2>, Members<3>, Members<4>, Members<5>, Members<6>, Members<7>,
+                 Members<8>>,
+        outer_product<Typelist<Read, Write>,
+                      outer_product<Typelist<Interleaved, ScalarSubscript, GatherScatter>,
+                                    all_real_vectors>>>);
@@ -25,62 +25,85 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 }}}*/
 
+#include <algorithm>
 #include <numeric>
+#include <utility>
 #include "benchmark.h"
+#include "plainloops.h"
+#include "roofline.h"
 
-struct Unrolled {};
-struct Simple {};
+template <int N> using Unroll = std::integral_constant<int, N>;
 
-template <typename T>
-inline void workLoop(const T *input, T *output, const int N, Simple)
+//! Calls f(integral_constant<int, 0>()), ..., f(integral_constant<int, N - 1>()).
+template <class F, int... Is>
+inline void unrolled(F &&f, std::integer_sequence<int, Is...>)
 {
-  using V = Vc::Vector<T>;
-  for (int i = 0; i < N; i += V::size()) {
-    (V(&input[i], Vc::Aligned) + 1).store(&output[i], Vc::Aligned);
-  }
+  int x[] = {0, (f(std::integral_constant<int, Is>()), 0)...};
+  (void)x;
 }
 
-template <typename T>
-inline void workLoop(const T *input, T *output, const int N, Unrolled)
+//! Software-pipelined loop: the stores of one chunk of U vectors are interleaved with
+//! the loads of the next chunk. N must be a non-zero multiple of U * V::size().
+template <typename V, int U>
+inline void workLoop(const typename V::EntryType *input, typename V::EntryType *output,
+                     const int N, Unroll<U>)
 {
-  using V = Vc::Vector<T>;
-  V x[4];
-  x[0] = (V(&input[0], Vc::Aligned) + 1);
-  x[1] = (V(&input[    V::size()], Vc::Aligned) + 1);
-  x[2] = (V(&input[2 * V::size()], Vc::Aligned) + 1);
-  x[3] = (V(&input[3 * V::size()], Vc::Aligned) + 1);
-  for (int i = 4 * V::size(); i < N; i += 4 * V::size()) {
-    x[0].store(&output[i - 4 * V::size()], Vc::Aligned);
-    x[0] = (V(&input[i], Vc::Aligned) + 1);
-    x[1].store(&output[i - 3 * V::size()], Vc::Aligned);
-    x[1] = (V(&input[i +     V::size()], Vc::Aligned) + 1);
-    x[2].store(&output[i - 2 * V::size()], Vc::Aligned);
-    x[2] = (V(&input[i + 2 * V::size()], Vc::Aligned) + 1);
-    x[3].store(&output[i - 1 * V::size()], Vc::Aligned);
-    x[3] = (V(&input[i + 3 * V::size()], Vc::Aligned) + 1);
+  constexpr int Step = U * V::size();
+  const auto lanes = std::make_integer_sequence<int, U>();
+  V x[U];
+  unrolled([&](auto k) { x[k] = (V(&input[k * V::size()], Vc::Aligned) + 1); }, lanes);
+  for (int i = Step; i < N; i += Step) {
+    unrolled(
+        [&](auto k) {
+          x[k].store(&output[i - Step + k * V::size()], Vc::Aligned);
+          x[k] = (V(&input[i + k * V::size()], Vc::Aligned) + 1);
+        },
+        lanes);
   }
-  x[0].store(&output[N - 4 * V::size()], Vc::Aligned);
-  x[1].store(&output[N - 3 * V::size()], Vc::Aligned);
-  x[2].store(&output[N - 2 * V::size()], Vc::Aligned);
-  x[3].store(&output[N - 1 * V::size()], Vc::Aligned);
+  unrolled([&](auto k) { x[k].store(&output[N - Step + k * V::size()], Vc::Aligned); },
+           lanes);
 }
 
+//! The argument is the working set (input + output) in bytes
 template <typename Config> void loop(benchmark::State &state)
 {
   using V = typename Config::template at<0>;
   using Unroll = typename Config::template at<1>;
   using T = typename V::EntryType;
   using Container = std::vector<T, Vc::Allocator<T>>;
-  constexpr int N = 16 * 1024;
+  constexpr int Step = Unroll::value * V::size();
+  const int N = std::max<int>(state.range(0) / (2 * sizeof(T)) / Step, 1) * Step;
+  Container  input(N);
+  Container output(N);
+  std::iota(std::begin(input), std::end(input), 0);
+  for (auto _ : state) {
+    workLoop<V>(&input[0], &output[0], N, Unroll());
+  }
+  // one addition, one load and one store per item
+  reportRoofline<V>(state, state.iterations() * N, 1, 2 * sizeof(T), 2 * N * sizeof(T));
+}
+
+Vc_BENCHMARK_TEMPLATE(
+    loop, outer_product<all_real_vectors,
+                        Typelist<Unroll<1>, Unroll<2>, Unroll<4>, Unroll<8>, Unroll<16>>>)
+    ->Apply(cacheSweepOf<1>);
+
+//! The same loop in plain C++, with and without compiler auto-vectorization
+template <typename Config> void plainLoop(benchmark::State &state)
+{
+  using T = typename Config::template at<0>;
+  using Loops = typename Config::template at<1>;
+  using Container = std::vector<T, Vc::Allocator<T>>;
+  const int N = std::max<int>(state.range(0) / (2 * sizeof(T)), 1);
   Container  input(N);
   Container output(N);
   std::iota(std::begin(input), std::end(input), 0);
   for (auto _ : state) {
-    workLoop(&input[0], &output[0], N, Unroll());
+    Loops::workLoop(&input[0], &output[0], N);
   }
-  const double items = state.iterations() * N;
-  state.counters["Items"] = items;
-  state.counters["Bytes"] = items * sizeof(T);
+  reportRoofline<T>(state, state.iterations() * N, 1, 2 * sizeof(T), 2 * N * sizeof(T));
 }
 
-Vc_BENCHMARK_TEMPLATE(loop, outer_product<all_real_vectors, Typelist<Simple, Unrolled>>);
+Vc_BENCHMARK_TEMPLATE(plainLoop, outer_product<selected_types<float, double>,
+                                               Typelist<AutoVectorized, NotVectorized>>)
+    ->Apply(cacheSweepOf<1>);
@@ -24,7 +24,11 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
 #ifndef MATH_FUNCTIONS_H
 #define MATH_FUNCTIONS_H
 #include <math.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <tuple>
+#include <vector>
 #include <Vc/Vc>
 
 using Vc::float_v;
@@ -56,6 +60,142 @@ inline PolarCoordinate<T> calculatePolarCoordinate(const Coordinate<T> &coord) {
   return r;
 }
 
+namespace fast_math_detail {
+inline float rsqrt(float x) { return 1.f / std::sqrt(x); }
+inline double rsqrt(double x) { return 1. / std::sqrt(x); }
+using Vc::rsqrt;
+}  // namespace fast_math_detail
+
+//! calculatePolarCoordinate with a relative error of about 1e-5 instead of full
+//! precision: the radius is r2 * rsqrt(r2) with one Newton step, the angle a minimax
+//! polynomial for atan on [0, 1] (in degrees) that is folded into the other octants.
+template <typename T>
+inline PolarCoordinate<T> calculatePolarCoordinateFast(const Coordinate<T> &coord) {
+  PolarCoordinate<T> r;
+
+  const T r2 = coord.x * coord.x + coord.y * coord.y;
+  // rsqrt(0) is inf; with the smallest normal instead, r2 * y is 0 as it should be
+  const T r2Clamped = Vc::iif(r2 < T(std::numeric_limits<float>::min()),
+                              T(std::numeric_limits<float>::min()), r2);
+  T y = fast_math_detail::rsqrt(r2Clamped);
+  y = y * (1.5f - 0.5f * r2Clamped * y * y);
+  r.radius = r2 * y;
+
+  const T ax = Vc::iif(coord.x < T(0), -coord.x, coord.x);
+  const T ay = Vc::iif(coord.y < T(0), -coord.y, coord.y);
+  const auto steep = ay > ax;
+  // a = min / max in [0, 1]; both 0 yields a = 0
+  const T a = Vc::iif(steep, ax, ay) / Vc::iif(steep, ay, Vc::iif(ax > T(0), ax, T(1)));
+  const T s = a * a;
+  T phi = a * (57.2944766f +
+               s * (-19.0579210f +
+                    s * (11.0892234f +
+                         s * (-6.67111205f + s * (3.01681301f + s * -0.671575291f)))));
+  phi = Vc::iif(steep, T(90.f) - phi, phi);
+  phi = Vc::iif(coord.x < T(0), T(180.f) - phi, phi);
+  r.phi = Vc::iif(coord.y < T(0), -phi, phi);
+
+  return r;
+}
+
+//! Largest errors of calculatePolarCoordinateFast on V against double precision: the
+//! relative error of the radius and the absolute error of phi in degrees. Sampled over
+//! radii from 1e-3 to 1e3 and the full circle.
+template <typename V> PolarCoordinate<double> calculatePolarCoordinateFastError() {
+  using TY = typename V::value_type;
+  constexpr std::size_t Radii = 64;
+  constexpr std::size_t Angles = 256;
+  constexpr std::size_t N = Radii * Angles;
+  static_assert(N % V::size() == 0, "the sample count must be a multiple of V::size()");
+  std::vector<TY> x(N), y(N), radius(N), phi(N);
+  for (std::size_t i = 0; i < N; ++i) {
+    const double length = 1e-3 * std::pow(1e6, double(i / Angles) / (Radii - 1));
+    const double angle = 2 * M_PI * double(i % Angles) / Angles - M_PI;
+    x[i] = length * std::cos(angle);
+    y[i] = length * std::sin(angle);
+  }
+  for (std::size_t i = 0; i < N; i += V::size()) {
+    const Coordinate<V> coord = {V(&x[i], Vc::Unaligned), V(&y[i], Vc::Unaligned)};
+    const PolarCoordinate<V> polar = calculatePolarCoordinateFast(coord);
+    polar.radius.store(&radius[i], Vc::Unaligned);
+    polar.phi.store(&phi[i], Vc::Unaligned);
+  }
+  PolarCoordinate<double> error = {0, 0};
+  for (std::size_t i = 0; i < N; ++i) {
+    const double exactRadius = std::hypot(double(x[i]), double(y[i]));
+    const double exactPhi = std::atan2(double(y[i]), double(x[i])) * (180 / M_PI);
+    const double phiError = std::abs(phi[i] - exactPhi);
+    error.radius = std::max(error.radius, std::abs(radius[i] - exactRadius) / exactRadius);
+    // +180 and -180 are the same angle
+    error.phi = std::max(error.phi, std::min(phiError, 360 - phiError));
+  }
+  return error;
+}
+
+//! FLOPs of one calculatePolarCoordinate: x * x + y * y (3), sqrt (1), the conversion to
+//! degrees (1) and atan2, counted as 20 for Vc's range reduction and polynomial.
+constexpr int polarCoordinateFlops = 25;
+
+// Kernels for the memory-layout benchmark, ordered by arithmetic intensity. Each maps the
+// two input fields (x, y) to the two output fields (radius, phi), on vectors and on the
+// scalar value_type alike. flops counts the FLOPs per item.
+
+//! radius = 0.5 * x, phi = 0.5 * y
+struct CopyScaleKernel {
+  static constexpr int flops = 2;
+  template <typename T> static PolarCoordinate<T> apply(const Coordinate<T> &coord) {
+    return {coord.x * 0.5f, coord.y * 0.5f};
+  }
+};
+
+//! Rotation by asin(0.6)
+struct RotateKernel {
+  static constexpr int flops = 6;
+  template <typename T> static PolarCoordinate<T> apply(const Coordinate<T> &coord) {
+    return {coord.x * 0.8f - coord.y * 0.6f, coord.x * 0.6f + coord.y * 0.8f};
+  }
+};
+
+//! Scales (x, y) to unit length
+struct NormalizeKernel {
+  static constexpr int flops = 7;
+  template <typename T> static PolarCoordinate<T> apply(const Coordinate<T> &coord) {
+    const T inverseLength = T(1) / sqrt(coord.x * coord.x + coord.y * coord.y);
+    return {coord.x * inverseLength, coord.y * inverseLength};
+  }
+};
+
+//! Squared distances to the points (1, 2) and (-3, 0.5)
+struct SquaredDistanceKernel {
+  static constexpr int flops = 10;
+  template <typename T> static PolarCoordinate<T> apply(const Coordinate<T> &coord) {
+    const T dx0 = coord.x - 1.f;
+    const T dy0 = coord.y - 2.f;
+    const T dx1 = coord.x + 3.f;
+    const T dy1 = coord.y - 0.5f;
+    return {dx0 * dx0 + dy0 * dy0, dx1 * dx1 + dy1 * dy1};
+  }
+};
+
+struct PolarKernel {
+  static constexpr int flops = polarCoordinateFlops;
+  template <typename T> static PolarCoordinate<T> apply(const Coordinate<T> &coord) {
+    return calculatePolarCoordinate(coord);
+  }
+};
+
+//! calculatePolarCoordinateFast: x * x + y * y (3), rsqrt with a Newton step (6), the
+//! radius (1), min / max (1), the polynomial (12) and the octant fold (2)
+struct FastPolarKernel {
+  static constexpr int flops = 25;
+  template <typename T> static PolarCoordinate<T> apply(const Coordinate<T> &coord) {
+    return calculatePolarCoordinateFast(coord);
+  }
+};
+
+//! Gather/scatter indexes for V; valid for native vectors and SimdArray alike
+template <typename V> using IndexesFor = Vc::SimdArray<int, V::size()>;
+
 constexpr size_t numberOfChunks(size_t inputSize, size_t chunkSize) {
   return (inputSize + chunkSize - 1) / chunkSize;
 }
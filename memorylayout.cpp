@@ -28,22 +28,96 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
 #include "aovs.h"
 #include "soa.h"
 #include "baseline.h"
-#include <Vc/cpuid.h>
+#include "plainloops.h"
+#include "perfcounters.h"
+#include "roofline.h"
+#include <chrono>
+#include <map>
 
-//! Tests all cache sizes
-void dynamicAllCacheSize(benchmark::internal::Benchmark *function) {
-  Vc::CpuId::init();
-
-  function->Range(1, Vc::CpuId::L3Data());
-}
+//! Every item loads x and y and stores radius and phi
+template <typename T> constexpr std::size_t polarBytesPerItem() { return 4 * sizeof(T); }
 
 struct RestScalar {};
 struct Padding {};
 
+template <typename T, typename Kernel> void reportKernelError(benchmark::State &, Kernel) {}
+
+//! Adds the largest errors of the approximation (relative for the radius, in degrees for
+//! phi) on T
+template <typename T> void reportKernelError(benchmark::State &state, FastPolarKernel) {
+  static const PolarCoordinate<double> error = calculatePolarCoordinateFastError<T>();
+  state.counters["RadiusErr"] = error.radius;
+  state.counters["PhiErr"] = error.phi;
+}
+
+//! One pass of Kernel over the first inputSize items of magic
+template <typename T, typename Kernel, typename P>
+inline void runLayout(P &magic, size_t inputSize, size_t containerSize,
+                      size_t missingSize) {
+  magic.setupLoop();
+
+  for (size_t n = 0; n < containerSize; n += T::size()) {
+    //! Loads the values to vc-vector
+    const auto coord = magic.load(n);
+
+    //! Apply the kernel
+    const auto polarCoord = Kernel::apply(coord);
+
+    //! Store the values from the vc-vector
+    magic.store(n, polarCoord);
+  }
+
+  for (size_t n = (inputSize - missingSize); n < inputSize; n++) {
+    magic.setPolarCoordinate(n, Kernel::apply(magic.coordinate(n)));
+  }
+}
+
+//! Seconds per item of the Baseline policy (the kernel without memory traffic) for the
+//! same T, Kernel and size; measured once per size, the best of three runs of >= 10 ms
+template <typename T, typename Kernel> double baselineSecondsPerItem(size_t inputSize) {
+  using clock = std::chrono::steady_clock;
+  static std::map<size_t, double> measured;
+  auto it = measured.find(inputSize);
+  if (it != measured.end()) {
+    return it->second;
+  }
+  const size_t containerSize = numberOfChunks(inputSize, T::size()) * T::size();
+  BaselineImpl<T> magic(containerSize);
+  double best = std::numeric_limits<double>::max();
+  for (int run = 0; run < 3; ++run) {
+    size_t passes = 0;
+    const auto start = clock::now();
+    double seconds = 0;
+    do {
+      runLayout<T, Kernel>(magic, containerSize, containerSize, 0);
+      ++passes;
+      seconds = std::chrono::duration<double>(clock::now() - start).count();
+    } while (seconds < 0.01);
+    best = std::min(best, seconds / (passes * inputSize));
+  }
+  return measured[inputSize] = best;
+}
+
+//! The time per item spent on data movement, i.e. above the Baseline: MemNs in ns per
+//! item and MemPct as a percentage of the total time
+template <typename T, typename Kernel, typename A>
+void reportMemoryOverhead(benchmark::State &state, size_t inputSize, double seconds, A) {
+  if (state.iterations() == 0 || state.error_occurred()) {
+    return;
+  }
+  const double total = seconds / (state.iterations() * inputSize);
+  const double memory = total - baselineSecondsPerItem<T, Kernel>(inputSize);
+  state.counters["MemNs"] = memory * 1e9;
+  state.counters["MemPct"] = 100 * memory / total;
+}
+template <typename T, typename Kernel>
+void reportMemoryOverhead(benchmark::State &, size_t, double, Baseline) {}
+
 template <typename TT> inline void benchmarkGenericMemoryLayout(benchmark::State &state) {
   using T = typename TT::template at<0>;
   using A = typename TT::template at<1>;
   using B = typename TT::template at<2>;
+  using Kernel = typename TT::template at<3>;
 
   typedef typename A::template type<T> P;
 
@@ -56,39 +130,88 @@ template <typename TT> inline void benchmarkGenericMemoryLayout(benchmark::State
 
   P magic(containerSize + missingSize);
 
+  PerfCounters perf;
+  perf.start();
+  const auto start = std::chrono::steady_clock::now();
   while (state.KeepRunning()) {
-    magic.setupLoop();
+    runLayout<T, Kernel>(magic, inputSize, containerSize, missingSize);
+  }
+  const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  perf.stop();
+  perf.report(state);
+  reportMemoryOverhead<T, Kernel>(state, inputSize, seconds, A());
+
+  constexpr size_t bytesPerItem = polarBytesPerItem<typename T::value_type>();
+  reportRoofline<T>(state, state.iterations() * inputSize, Kernel::flops, bytesPerItem,
+                    inputSize * bytesPerItem);
+  reportKernelError<T>(state, Kernel());
+}
+
+using MemoryLayouts =
+    concat<outer_product<Typelist<AovsAccess, Baseline>, Typelist<Padding>>,
+           outer_product<Typelist<AosSubscriptAccess, InterleavedAccess,
+                                  AosGatherScatterAccess, SoaSubscriptAccess,
+                                  LoadStoreAccess, SoaGatherScatterAccess>,
+                         Typelist<Padding, RestScalar>>>;
 
-    for (size_t n = 0; n < containerSize; n += T::size()) {
-      //! Loads the values to vc-vector
-      const auto coord = magic.load(n);
+//! From memory bound to compute bound
+using Kernels = Typelist<CopyScaleKernel, RotateKernel, NormalizeKernel,
+                         SquaredDistanceKernel, FastPolarKernel, PolarKernel>;
+
+// one registration per element type, so that the sweep knows the bytes per item
+Vc_BENCHMARK_TEMPLATE(
+    benchmarkGenericMemoryLayout,
+    outer_product<concat<all_vectors_of<float, false>, simdarrays_of<float, 8, 16, 32>>,
+                  outer_product<MemoryLayouts, Kernels>>)
+    ->Apply(cacheSweepOf<polarBytesPerItem<float>()>);
+Vc_BENCHMARK_TEMPLATE(
+    benchmarkGenericMemoryLayout,
+    outer_product<concat<all_vectors_of<double, false>, simdarrays_of<double, 4, 8, 16>>,
+                  outer_product<MemoryLayouts, Kernels>>)
+    ->Apply(cacheSweepOf<polarBytesPerItem<double>()>);
 
-      //! Calculate the polarcoordinates
-      const auto polarCoord = calculatePolarCoordinate(coord); //Ändern
+struct AosLoop {};
+struct SoaLoop {};
 
-      //! Store the values from the vc-vector
-      magic.store(n, polarCoord);
-    }
+template <typename T, typename Loops>
+inline void plainLoop(AosLayout<Vc::Scalar::Vector<T>> &data, size_t size, AosLoop) {
+  Loops::polarAos(data.inputValues.data(), data.outputValues.data(), size);
+}
 
-    for (size_t n = (inputSize - missingSize); n < inputSize; n++) {
-      magic.setPolarCoordinate(
-          n,
-          calculatePolarCoordinate(magic.coordinate(n))); // Gibt Coordinate FLOAT
-    }
+template <typename T, typename Loops>
+inline void plainLoop(SoaLayout<Vc::Scalar::Vector<T>> &data, size_t size, SoaLoop) {
+  Loops::polarSoa(data.inputValues.x.data(), data.inputValues.y.data(),
+                  data.outputValues.radius.data(), data.outputValues.phi.data(), size);
+}
+
+//! The polar kernel as a plain loop, with and without compiler auto-vectorization
+template <typename TT> inline void plainMemoryLayout(benchmark::State &state) {
+  using T = typename TT::template at<0>;
+  using L = typename TT::template at<1>;
+  using Loops = typename TT::template at<2>;
+  using V = Vc::Scalar::Vector<T>;
+  using Data = typename std::conditional<std::is_same<L, AosLoop>::value, AosLayout<V>,
+                                         SoaLayout<V>>::type;
+
+  const size_t inputSize = state.range(0);
+  Data data(inputSize);
+
+  while (state.KeepRunning()) {
+    plainLoop<T, Loops>(data, inputSize, L());
   }
 
-  const double items = state.iterations() * state.range(0);
-  state.counters["Items"] = items;
-  state.counters["Bytes"] = items * sizeof(typename T::value_type);
+  constexpr size_t bytesPerItem = polarBytesPerItem<T>();
+  reportRoofline<T>(state, state.iterations() * inputSize, polarCoordinateFlops,
+                    bytesPerItem, inputSize * bytesPerItem);
 }
 
-Vc_BENCHMARK_TEMPLATE(
-    benchmarkGenericMemoryLayout,
-    outer_product<
-        all_real_vectors_wo_simdarray,
-        concat<outer_product<Typelist<AovsAccess, Baseline>, Typelist<Padding>>,
-               outer_product<
-                   Typelist<AosSubscriptAccess, InterleavedAccess, AosGatherScatterAccess,
-                            SoaSubscriptAccess, LoadStoreAccess, SoaGatherScatterAccess>,
-                   Typelist<Padding, RestScalar>>>>)
-    ->Apply(dynamicAllCacheSize);
+using PlainLayouts =
+    outer_product<Typelist<AosLoop, SoaLoop>, Typelist<AutoVectorized, NotVectorized>>;
+
+Vc_BENCHMARK_TEMPLATE(plainMemoryLayout,
+                      outer_product<selected_types<float>, PlainLayouts>)
+    ->Apply(cacheSweepOf<polarBytesPerItem<float>()>);
+Vc_BENCHMARK_TEMPLATE(plainMemoryLayout,
+                      outer_product<selected_types<double>, PlainLayouts>)
+    ->Apply(cacheSweepOf<polarBytesPerItem<double>()>);
@@ -0,0 +1,231 @@
+/*{{{
+Copyright © 2018 Matthias Kretz <kretz@kde.org>
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the names of contributing organizations nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+}}}*/
+
+#include "benchmark.h"
+#include "roofline.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// N-body forces on particles simdized with Vc_SIMDIZE_INTERFACE (as in
+// nearestneighbor.cpp). The inner loop runs over V::size() j-particles at a time against
+// one broadcast i-particle, so its loads depend on the layout of the particles:
+//   Aos   std::vector<Particle>, deinterleaved by the simdize generator constructor
+//   Soa   one array per member, aligned vector loads
+//   Aovs  std::vector<ParticleV>, one simdized particle per V::size() particles
+// Tile<N> splits the j-particles into tiles of N that stay in L1 while all i-particles
+// pass over them; Tile<0> runs over all j-particles for every i. Benchmark threads split
+// the i-particles between them. The argument is the number of particles.
+// Reports Pairs (interactions/s) and the roofline counters (see roofline.h) of the
+// j-particles loaded per pair, with the tile as working set.
+
+template <class T> struct ParticleTemplate {
+  T x, y, z, m;
+  Vc_SIMDIZE_INTERFACE((x, y, z, m));
+};
+
+template <class T> using Array = std::vector<T, Vc::Allocator<T>>;
+
+//! The particles of all layouts, one array per member
+template <class T> struct ParticleArrays {
+  Array<T> x, y, z, m;
+
+  ParticleArrays(std::size_t n, T box) : x(n), y(n), z(n), m(n) {
+    fillUniform(x.data(), n, T(0), box, 0);
+    fillUniform(y.data(), n, T(0), box, 1);
+    fillUniform(z.data(), n, T(0), box, 2);
+    fillUniform(m.data(), n, T(0.5), T(1), 3);
+  }
+
+  ParticleTemplate<T> operator[](std::size_t i) const { return {x[i], y[i], z[i], m[i]}; }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// kernels
+//
+// accumulate() adds the acceleration of particle i by the particles pj to a.
+
+//! All-pairs gravity (G = 1), softened so that the interaction of a particle with
+//! itself contributes zero instead of NaN
+struct Gravity {
+  static constexpr int Flops = 20;
+
+  template <class T> static T boxSize(std::size_t) { return T(1); }
+
+  template <class P, class PV, class VT>
+  static void accumulate(const P &pi, const PV &pj, VT (&a)[3]) {
+    const VT dx = pj.x - pi.x;
+    const VT dy = pj.y - pi.y;
+    const VT dz = pj.z - pi.z;
+    const VT r2 = dx * dx + dy * dy + dz * dz + VT(1e-4f);
+    const VT inv = Vc::rsqrt(r2);
+    const VT s = pj.m * inv * inv * inv;
+    a[0] += dx * s;
+    a[1] += dy * s;
+    a[2] += dz * s;
+  }
+};
+
+//! Lennard-Jones (epsilon = sigma = 1) with a cutoff radius of 2.5, at a density of
+//! 0.8 particles per unit volume, i.e. about 50 neighbours within the cutoff. Without
+//! cell lists all pairs are evaluated, most of them masked.
+struct LennardJones {
+  static constexpr int Flops = 23;
+
+  template <class T> static T boxSize(std::size_t n) {
+    return T(std::cbrt(n / 0.8));
+  }
+
+  template <class P, class PV, class VT>
+  static void accumulate(const P &pi, const PV &pj, VT (&a)[3]) {
+    const VT dx = pj.x - pi.x;
+    const VT dy = pj.y - pi.y;
+    const VT dz = pj.z - pi.z;
+    const VT r2 = dx * dx + dy * dy + dz * dz;
+    const auto inRange = r2 < VT(6.25f) && r2 > VT(0);
+    const VT inv2 = VT(1) / Vc::iif(inRange, r2, VT(1));
+    const VT inv6 = inv2 * inv2 * inv2;
+    const VT s = Vc::iif(inRange, VT(24) * inv2 * inv6 * (VT(2) * inv6 - VT(1)), VT(0));
+    a[0] -= dx * s;
+    a[1] -= dy * s;
+    a[2] -= dz * s;
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// layouts
+//
+// type<T, PV> is constructed from the ParticleArrays<T>; load(j) returns the particles
+// j, ..., j + PV::size() - 1.
+
+struct Aos {
+  template <class T, class PV> struct type {
+    std::vector<ParticleTemplate<T>> data;
+
+    explicit type(const ParticleArrays<T> &input) {
+      data.reserve(input.x.size());
+      for (std::size_t i = 0; i < input.x.size(); ++i) {
+        data.push_back(input[i]);
+      }
+    }
+    PV load(std::size_t j) const {
+      return PV([&](int k) { return data[j + k]; });
+    }
+  };
+};
+
+struct Soa {
+  template <class T, class PV> struct type {
+    using VT = Vc::simdize<T, PV::size()>;
+    const ParticleArrays<T> &data;
+
+    explicit type(const ParticleArrays<T> &input) : data(input) {}
+    PV load(std::size_t j) const {
+      PV p;
+      p.x = VT(&data.x[j], Vc::Aligned);
+      p.y = VT(&data.y[j], Vc::Aligned);
+      p.z = VT(&data.z[j], Vc::Aligned);
+      p.m = VT(&data.m[j], Vc::Aligned);
+      return p;
+    }
+  };
+};
+
+struct Aovs {
+  template <class T, class PV> struct type {
+    std::vector<PV, Vc::Allocator<PV>> data;
+
+    explicit type(const ParticleArrays<T> &input) {
+      data.reserve(input.x.size() / PV::size());
+      for (std::size_t i = 0; i < input.x.size(); i += PV::size()) {
+        data.push_back(PV([&](int k) { return input[i + k]; }));
+      }
+    }
+    PV load(std::size_t j) const { return data[j / PV::size()]; }
+  };
+};
+
+template <int N> using Tile = std::integral_constant<int, N>;
+
+template <class Config> void nbody(benchmark::State &state) {
+  using Kernel = typename Config::template at<0>;
+  using Layout = typename Config::template at<1>;
+  using TileSize = typename Config::template at<2>;
+  using V = typename Config::template at<3>;
+  using T = typename V::EntryType;
+  using PV = Vc::simdize<ParticleTemplate<T>, V::size()>;
+  using VT = Vc::simdize<T, V::size()>;
+
+  const std::size_t n =
+      std::max<std::size_t>(state.range(0) / V::size(), 1) * V::size();
+  const ParticleArrays<T> input(n, Kernel::template boxSize<T>(n));
+  const typename Layout::template type<T, PV> particles(input);
+  const std::size_t tile = TileSize::value == 0 ? n : TileSize::value;
+
+  // this thread's share of the i-particles
+  const std::size_t index = benchmarkThreadIndex(state);
+  const std::size_t threads = benchmarkThreads(state);
+  const std::size_t begin = n * index / threads;
+  const std::size_t end = n * (index + 1) / threads;
+  Array<T> acceleration(3 * (end - begin));
+
+  for (auto _ : state) {
+    std::fill(acceleration.begin(), acceleration.end(), T(0));
+    for (std::size_t j0 = 0; j0 < n; j0 += tile) {
+      const std::size_t j1 = std::min(j0 + tile, n);
+      for (std::size_t i = begin; i < end; ++i) {
+        const auto pi = input[i];
+        VT a[3] = {VT(0), VT(0), VT(0)};
+        for (std::size_t j = j0; j < j1; j += V::size()) {
+          Kernel::accumulate(pi, particles.load(j), a);
+        }
+        for (int k = 0; k < 3; ++k) {
+          acceleration[3 * (i - begin) + k] += a[k].sum();
+        }
+      }
+    }
+    benchmark::ClobberMemory();
+  }
+
+  const double pairs = double(state.iterations()) * (end - begin) * n;
+  state.counters["Pairs"] = benchmark::Counter(pairs, benchmark::Counter::kIsRate);
+  reportRoofline<V>(state, pairs, Kernel::Flops, sizeof(ParticleTemplate<T>),
+                    tile * sizeof(ParticleTemplate<T>));
+}
+
+Vc_BENCHMARK_TEMPLATE(
+    nbody,
+    outer_product<Typelist<Gravity, LennardJones>,
+                  outer_product<Typelist<Aos, Soa, Aovs>,
+                                outer_product<Typelist<Tile<0>, Tile<512>>,
+                                              all_real_vectors>>>)
+    ->Arg(512)
+    ->Arg(2048)
+    ->Arg(8192)
+    ->UseRealTime()
+    ->Threads(1)
+    ->ThreadPerCpu();
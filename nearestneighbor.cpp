@@ -1,6 +1,6 @@
 #include "benchmark.h"
+#include "plainloops.h"
 #include <limits>
-#include <random>
 #include <Vc/algorithm>
 
 template <class Float = float> struct PositionTemplate {
@@ -57,23 +57,32 @@ struct simd_for_each {
   }
 };
 
-std::random_device rd;
-std::mt19937 gen(rd());
-std::uniform_real_distribution<float> rnd0_10(0.f, 10.f);
+template <class Loops> struct plain_loop {
+  static_assert(sizeof(Position) == 3 * sizeof(float),
+                "plain_loop requires Position to be three packed floats");
 
-std::vector<Position> create_particles(int size) {
-  std::vector<Position> particles;
-  particles.reserve(size);
-  for (; size; --size) {
-    particles.push_back({rnd0_10(gen), rnd0_10(gen), rnd0_10(gen)});
+  int operator()(const Position to, const std::vector<Position> &particles) {
+    return Loops::nearest(&particles[0].x, particles.size(), to.x, to.y, to.z);
   }
+};
+
+std::vector<Position> create_particles(int size) {
+  static_assert(sizeof(Position) == 3 * sizeof(float), "Position must be packed");
+  std::vector<Position> particles(size);
+  fillUniform(&particles[0].x, 3 * particles.size(), 0.f, 10.f);
   return particles;
 }
 
+//! The point to search from, the same for all methods
+Position create_target() {
+  return {uniformAt(0, 0.f, 10.f, 1), uniformAt(1, 0.f, 10.f, 1),
+          uniformAt(2, 0.f, 10.f, 1)};
+}
+
 template <class Method, class Verify>
 void find_nearest(benchmark::State &state) {
   const auto particles = create_particles(state.range(0));
-  Position to{rnd0_10(gen), rnd0_10(gen), rnd0_10(gen)};
+  Position to = create_target();
   Method findNearest;
   int index = 0;
   for (auto _ : state) {
@@ -87,18 +96,19 @@ void find_nearest(benchmark::State &state) {
     std::cerr << "the find implementations don't agree\n";
   }
   state.counters["Bytes"] = state.iterations() * particles.size() * sizeof(Position);
+  labelCacheLevel(state, particles.size() * sizeof(Position));
 }
 
 void aovs(benchmark::State &state) {
-  int size = state.range(0);
+  // the same particles as find_nearest, padded to a multiple of PositionV::size()
+  const std::size_t chunks = (state.range(0) + PositionV::size() - 1) / PositionV::size();
+  const auto scalarParticles = create_particles(chunks * PositionV::size());
   std::vector<PositionV> particles;
-  particles.reserve(size / PositionV::size());
-  for (; size > 0; size -= PositionV::size()) {
-    particles.push_back(PositionV([](int) -> Position {
-      return {rnd0_10(gen), rnd0_10(gen), rnd0_10(gen)};
-    }));
+  particles.reserve(chunks);
+  for (std::size_t i = 0; i < scalarParticles.size(); i += PositionV::size()) {
+    particles.push_back(PositionV([&](int n) { return scalarParticles[i + n]; }));
   }
-  Position to{rnd0_10(gen), rnd0_10(gen), rnd0_10(gen)};
+  Position to = create_target();
   for (auto _ : state) {
     to.x *= 0.9f;
     to.y *= 0.9f;
@@ -119,8 +129,15 @@ void aovs(benchmark::State &state) {
     benchmark::DoNotOptimize(best_index[index_of_min(best)]);
   }
   state.counters["Bytes"] = state.iterations() * particles.size() * sizeof(PositionV);
+  labelCacheLevel(state, particles.size() * sizeof(PositionV));
 }
 
-BENCHMARK_TEMPLATE(find_nearest, std_for_each, simd_for_each)->Range(8, 8 << 20);
-BENCHMARK_TEMPLATE(find_nearest, simd_for_each, std_for_each)->Range(8, 8 << 20);
-BENCHMARK(aovs)->Range(8, 8 << 20);
+BENCHMARK_TEMPLATE(find_nearest, std_for_each, simd_for_each)
+    ->Apply(cacheSweepOf<sizeof(Position)>);
+BENCHMARK_TEMPLATE(find_nearest, simd_for_each, std_for_each)
+    ->Apply(cacheSweepOf<sizeof(Position)>);
+BENCHMARK_TEMPLATE(find_nearest, plain_loop<AutoVectorized>, std_for_each)
+    ->Apply(cacheSweepOf<sizeof(Position)>);
+BENCHMARK_TEMPLATE(find_nearest, plain_loop<NotVectorized>, std_for_each)
+    ->Apply(cacheSweepOf<sizeof(Position)>);
+BENCHMARK(aovs)->Apply(cacheSweepOf<sizeof(Position)>);
@@ -0,0 +1,200 @@
+/*{{{
+Copyright © 2018 Matthias Kretz <kretz@kde.org>
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the names of contributing organizations nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+}}}*/
+
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Hardware performance counters via perf_event_open, reported per iteration as
+// benchmark counters. A benchmark opts in like this:
+//
+//   PerfCounters perf;
+//   perf.start();
+//   for (auto _ : state) { ... }
+//   perf.stop();
+//   perf.report(state);
+//
+// If the counters cannot be opened (not Linux, no PMU in a VM, or restricted by
+// /proc/sys/kernel/perf_event_paranoid) report() adds nothing, and the benchmark falls
+// back to plain timing.
+class PerfCounters {
+  struct Event {
+    const char *name;
+    std::uint32_t type;
+    std::uint64_t config;
+  };
+
+  static constexpr std::uint64_t cacheMiss(std::uint64_t cache) {
+#ifdef __linux__
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+           (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+#else
+    return cache;
+#endif
+  }
+
+public:
+  PerfCounters() {
+#ifdef __linux__
+    const Event events[] = {
+        {"Cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {"Instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {"L1DMisses", PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_L1D)},
+        {"LLCMisses", PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_LL)},
+        {"DTLBMisses", PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_DTLB)},
+        {"BranchMisses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    };
+    for (const Event &e : events) {
+      perf_event_attr attr = {};
+      attr.size = sizeof(attr);
+      attr.type = e.type;
+      attr.config = e.config;
+      attr.disabled = leader < 0;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                         PERF_FORMAT_TOTAL_TIME_RUNNING;
+      const int fd = syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0);
+      if (fd < 0) {
+        if (leader < 0) {
+          warnOnce();
+          return;  // without cycles there is nothing to group the other events on
+        }
+        continue;  // this event is not supported; count the rest
+      }
+      if (leader < 0) {
+        leader = fd;
+      }
+      fds.push_back(fd);
+      names.push_back(e.name);
+    }
+#endif
+  }
+
+  ~PerfCounters() {
+#ifdef __linux__
+    for (int fd : fds) {
+      close(fd);
+    }
+#endif
+  }
+
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+
+  bool available() const { return leader >= 0; }
+
+  void start() {
+#ifdef __linux__
+    if (available()) {
+      ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+      ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+  }
+
+  void stop() {
+#ifdef __linux__
+    if (available()) {
+      ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+  }
+
+  //! Counter values of the last start()/stop() interval, scaled for multiplexing.
+  //! Returns an empty vector if the counters are not available.
+  std::vector<double> values() const {
+    std::vector<double> r;
+#ifdef __linux__
+    if (!available()) {
+      return r;
+    }
+    // layout for PERF_FORMAT_GROUP: nr, time_enabled, time_running, value[nr]
+    std::vector<std::uint64_t> buf(3 + fds.size());
+    const auto bytes = read(leader, buf.data(), buf.size() * sizeof(std::uint64_t));
+    if (bytes < static_cast<ssize_t>(3 * sizeof(std::uint64_t)) || buf[2] == 0) {
+      return r;
+    }
+    const double scale = double(buf[1]) / double(buf[2]);
+    for (std::size_t i = 0; i < buf[0] && i < fds.size(); ++i) {
+      r.push_back(buf[3 + i] * scale);
+    }
+#endif
+    return r;
+  }
+
+  //! Adds one counter per event, divided by the number of iterations, plus IPC.
+  void report(benchmark::State &state) const {
+    const std::vector<double> v = values();
+    if (v.empty() || state.iterations() == 0) {
+      return;
+    }
+    const double iterations = state.iterations();
+    double cycles = 0, instructions = 0;
+    for (std::size_t i = 0; i < v.size(); ++i) {
+      state.counters[names[i]] =
+          benchmark::Counter(v[i] / iterations, benchmark::Counter::kAvgThreads);
+      if (names[i] == std::string("Cycles")) {
+        cycles = v[i];
+      } else if (names[i] == std::string("Instructions")) {
+        instructions = v[i];
+      }
+    }
+    if (cycles > 0 && instructions > 0) {
+      state.counters["IPC"] =
+          benchmark::Counter(instructions / cycles, benchmark::Counter::kAvgThreads);
+    }
+  }
+
+private:
+  static void warnOnce() {
+    static bool warned = false;
+    if (!warned) {
+      warned = true;
+      std::fprintf(stderr,
+                   "perf_event_open failed; hardware counters disabled (check "
+                   "/proc/sys/kernel/perf_event_paranoid)\n");
+    }
+  }
+
+  int leader = -1;
+  std::vector<int> fds;
+  std::vector<const char *> names;
+};
+
+#endif // PERFCOUNTERS_H
@@ -0,0 +1,115 @@
+/*{{{
+Copyright © 2018 Matthias Kretz <kretz@kde.org>
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the names of contributing organizations nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+}}}*/
+
+
+#include "plainloops.h"
+#include "quadsolve.h"
+#include <cmath>
+#include <limits>
+
+#ifndef Vc_PLAIN_LOOPS
+#error "Vc_PLAIN_LOOPS must name the struct to define (AutoVectorized or NotVectorized)"
+#endif
+
+namespace {
+template <typename T>
+inline void polarAosImpl(const Coordinate<T> *input, PolarCoordinate<T> *output,
+                         std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    const T x = input[i].x;
+    const T y = input[i].y;
+    output[i].radius = std::sqrt(x * x + y * y);
+    output[i].phi = std::atan2(y, x) * T(57.295780181884765625f);
+  }
+}
+
+template <typename T>
+inline void polarSoaImpl(const T *x, const T *y, T *radius, T *phi, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    radius[i] = std::sqrt(x[i] * x[i] + y[i] * y[i]);
+    phi[i] = std::atan2(y[i], x[i]) * T(57.295780181884765625f);
+  }
+}
+
+template <typename T>
+inline void workLoopImpl(const T *input, T *output, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    output[i] = input[i] + 1;
+  }
+}
+}  // namespace
+
+void Vc_PLAIN_LOOPS::polarAos(const Coordinate<float> *input,
+                              PolarCoordinate<float> *output, std::size_t n) {
+  polarAosImpl(input, output, n);
+}
+
+void Vc_PLAIN_LOOPS::polarAos(const Coordinate<double> *input,
+                              PolarCoordinate<double> *output, std::size_t n) {
+  polarAosImpl(input, output, n);
+}
+
+void Vc_PLAIN_LOOPS::polarSoa(const float *x, const float *y, float *radius, float *phi,
+                              std::size_t n) {
+  polarSoaImpl(x, y, radius, phi, n);
+}
+
+void Vc_PLAIN_LOOPS::polarSoa(const double *x, const double *y, double *radius,
+                              double *phi, std::size_t n) {
+  polarSoaImpl(x, y, radius, phi, n);
+}
+
+void Vc_PLAIN_LOOPS::workLoop(const float *input, float *output, std::size_t n) {
+  workLoopImpl(input, output, n);
+}
+
+void Vc_PLAIN_LOOPS::workLoop(const double *input, double *output, std::size_t n) {
+  workLoopImpl(input, output, n);
+}
+
+void Vc_PLAIN_LOOPS::quadSolve(const float *a, const float *b, const float *c, float *x1,
+                               float *x2, int *roots, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    QuadSolve<float>(a[i], b[i], c[i], x1[i], x2[i], roots[i]);
+  }
+}
+
+int Vc_PLAIN_LOOPS::nearest(const float *xyz, std::size_t n, float x, float y, float z) {
+  float best = std::numeric_limits<float>::max();
+  int best_index = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    const float dx = xyz[3 * i] - x;
+    const float dy = xyz[3 * i + 1] - y;
+    const float dz = xyz[3 * i + 2] - z;
+    const float distance2 = dx * dx + dy * dy + dz * dz;
+    if (distance2 < best) {
+      best = distance2;
+      best_index = i;
+    }
+  }
+  return best_index;
+}
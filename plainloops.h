@@ -0,0 +1,57 @@
+/*{{{
+Copyright © 2018 Matthias Kretz <kretz@kde.org>
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the names of contributing organizations nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+}}}*/
+
+#ifndef PLAINLOOPS_H
+#define PLAINLOOPS_H
+#include <cstddef>
+#include "mathfunctions.h"
+
+// Plain C++ loops of the benchmarked kernels, without any Vc types. plainloops.cpp is
+// compiled twice per benchmark (add_benchmark(... PLAIN_LOOPS) in CMakeLists.txt): once
+// with auto-vectorization enabled and once with it disabled. This gives a baseline for
+// what the compiler achieves on its own.
+#define Vc_DECLARE_PLAIN_LOOPS(name_)                                                    \
+  struct name_ {                                                                         \
+    static void polarAos(const Coordinate<float> *input,                                 \
+                         PolarCoordinate<float> *output, std::size_t n);                 \
+    static void polarAos(const Coordinate<double> *input,                                \
+                         PolarCoordinate<double> *output, std::size_t n);                \
+    static void polarSoa(const float *x, const float *y, float *radius, float *phi,      \
+                         std::size_t n);                                                 \
+    static void polarSoa(const double *x, const double *y, double *radius, double *phi,  \
+                         std::size_t n);                                                 \
+    static void workLoop(const float *input, float *output, std::size_t n);              \
+    static void workLoop(const double *input, double *output, std::size_t n);            \
+    static void quadSolve(const float *a, const float *b, const float *c, float *x1,     \
+                          float *x2, int *roots, std::size_t n);                         \
+    static int nearest(const float *xyz, std::size_t n, float x, float y, float z);      \
+  }
+
+Vc_DECLARE_PLAIN_LOOPS(AutoVectorized);
+Vc_DECLARE_PLAIN_LOOPS(NotVectorized);
+
+#endif // PLAINLOOPS_H
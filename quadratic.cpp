@@ -27,6 +27,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 }}}*/
 
 #include "benchmark.h"
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 #include <cstdint>
@@ -35,39 +36,11 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <malloc.h>
 #include <x86intrin.h>
 #include <Vc/Vc>
+#include "quadsolve.h"
+#include "plainloops.h"
 
 static const int N = (8 * 1024 * 1024);
 
-// solve ax2 + bx + c = 0
-
-template <typename T>
-void QuadSolve(const T &a, const T &b, const T &c, T &x1, T &x2, int &roots)
-{
-  T a_inv = T(1.0) / a;
-  T delta = b * b - T(4.0) * a * c;
-  T s = (b >= 0) ? T(1.0) : T(-1.0);
-
-  roots = delta > std::numeric_limits<T>::epsilon() ? 2 : delta < T(0.0) ? 0 : 1;
-
-  switch (roots) {
-  case 2:
-    x1 = T(-0.5) * (b + s * std::sqrt(delta));
-    x2 = c / x1;
-    x1 *= a_inv;
-    return;
-
-  case 0:
-    return;
-
-  case 1:
-    x1 = x2 = T(-0.5) * b * a_inv;
-    return;
-
-  default:
-    return;
-  }
-}
-
 #if defined(__AVX2__)
 
 // explicit AVX2 code using intrinsics
@@ -116,50 +89,16 @@ QuadSolveAVX(const float *__restrict__ a, const float *__restrict__ b, const flo
 using Float_v = Vc::Vector<float>;
 using Int32_v = Vc::Vector<int32_t>;
 
-void QuadSolveSIMD(Float_v const &a, Float_v const &b,
-                   Float_v const &c, Float_v &x1, Float_v &x2,
-                   Int32_v &roots)
-{
-  using FMask = typename Float_v::Mask;
-  using IMask = typename Int32_v::Mask;
-
-  Float_v a_inv = Float_v(1.0f) / a;
-  Float_v delta = b * b - Float_v(4.0f) * a * c;
-  Float_v sign = iif(FMask(b >= Float_v(0.0f)), Float_v(1.0f), Float_v(-1.0f));
-
-  FMask mask0(delta < Float_v(0.0f));
-  FMask mask2(delta >= Float_v(std::numeric_limits<float>::epsilon()));
-
-  Float_v root1 = Float_v(-0.5f) * (b + sign * std::sqrt(delta));
-  Float_v root2 = c / root1;
-  root1 = root1 * a_inv;
-
-  FMask mask1 = !(mask2 || mask0);
-
-  x1(mask2) = root1;
-  x2(mask2) = root2;
-  roots = iif(simd_cast<IMask>(mask2), Int32_v(2), Int32_v(0));
-
-  if (mask1.isEmpty())
-    return;
-
-  root1 = Float_v(-0.5f) * b * a_inv;
-  roots(simd_cast<IMask>(mask1)) = Int32_v(1);
-  x1(mask1) = root1;
-  x2(mask1) = root1;
-}
-
 struct Data {
   Data() {
-    srand48(time(NULL));
-    for (int i = 0; i < N; i++) {
-      a[i] = 10.0 * (drand48() - 0.5);
-      b[i] = 10.0 * (drand48() - 0.5);
-      c[i] = 50.0 * (drand48() - 0.5);
-      x1[i] = 0.0;
-      x2[i] = 0.0;
-      roots[i] = 0;
-    }
+    fillUniform(a, N, -5.f, 5.f, 0);
+    fillUniform(b, N, -5.f, 5.f, 1);
+    fillUniform(c, N, -25.f, 25.f, 2);
+    parallelFor(N, [&](std::size_t begin, std::size_t end) {
+      std::fill(x1 + begin, x1 + end, 0.f);
+      std::fill(x2 + begin, x2 + end, 0.f);
+      std::fill(roots + begin, roots + end, 0);
+    });
   }
 
   float *a = (float *)memalign(64, N * sizeof(float));
@@ -205,7 +144,17 @@ void vc(benchmark::State &state) {
   }
 }
 
+//! QuadSolve in a plain loop, with and without compiler auto-vectorization
+template <typename Loops> void plain(benchmark::State &state) {
+  Data d;
+  for (auto _ : state) {
+    Loops::quadSolve(d.a, d.b, d.c, d.x1, d.x2, d.roots, N);
+  }
+}
+
 BENCHMARK(scalar);
+BENCHMARK_TEMPLATE(plain, AutoVectorized);
+BENCHMARK_TEMPLATE(plain, NotVectorized);
 #ifdef __AVX2__
 BENCHMARK(intrinsics);
 #endif
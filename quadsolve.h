@@ -0,0 +1,105 @@
+/*{{{
+Copyright © 2016 Guilherme Amadio
+Copyright © 2016-2018 Matthias Kretz <kretz@kde.org>
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the names of contributing organizations nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+}}}*/
+
+#ifndef QUADSOLVE_H
+#define QUADSOLVE_H
+#include <cmath>
+#include <limits>
+#include <Vc/Vc>
+
+// solve ax2 + bx + c = 0
+
+template <typename T>
+void QuadSolve(const T &a, const T &b, const T &c, T &x1, T &x2, int &roots)
+{
+  T a_inv = T(1.0) / a;
+  T delta = b * b - T(4.0) * a * c;
+  T s = (b >= 0) ? T(1.0) : T(-1.0);
+
+  roots = delta > std::numeric_limits<T>::epsilon() ? 2 : delta < T(0.0) ? 0 : 1;
+
+  switch (roots) {
+  case 2:
+    x1 = T(-0.5) * (b + s * std::sqrt(delta));
+    x2 = c / x1;
+    x1 *= a_inv;
+    return;
+
+  case 0:
+    return;
+
+  case 1:
+    x1 = x2 = T(-0.5) * b * a_inv;
+    return;
+
+  default:
+    return;
+  }
+}
+
+// explicit SIMD code using Vc
+//
+// Int32_v must have as many entries as Float_v. Use SimdArray<int, Float_v::size()> if
+// the native int vector is narrower than the native float vector (e.g. AVX without
+// AVX2).
+
+template <typename Float_v, typename Int32_v>
+void QuadSolveSIMD(Float_v const &a, Float_v const &b,
+                   Float_v const &c, Float_v &x1, Float_v &x2,
+                   Int32_v &roots)
+{
+  using FMask = typename Float_v::Mask;
+  using IMask = typename Int32_v::Mask;
+
+  Float_v a_inv = Float_v(1.0f) / a;
+  Float_v delta = b * b - Float_v(4.0f) * a * c;
+  Float_v sign = Vc::iif(FMask(b >= Float_v(0.0f)), Float_v(1.0f), Float_v(-1.0f));
+
+  FMask mask0(delta < Float_v(0.0f));
+  FMask mask2(delta >= Float_v(std::numeric_limits<float>::epsilon()));
+
+  Float_v root1 = Float_v(-0.5f) * (b + sign * Vc::sqrt(delta));
+  Float_v root2 = c / root1;
+  root1 = root1 * a_inv;
+
+  FMask mask1 = !(mask2 || mask0);
+
+  x1(mask2) = root1;
+  x2(mask2) = root2;
+  roots = Vc::iif(Vc::simd_cast<IMask>(mask2), Int32_v(2), Int32_v(0));
+
+  if (mask1.isEmpty())
+    return;
+
+  root1 = Float_v(-0.5f) * b * a_inv;
+  roots(Vc::simd_cast<IMask>(mask1)) = Int32_v(1);
+  x1(mask1) = root1;
+  x2(mask1) = root1;
+}
+
+#endif // QUADSOLVE_H
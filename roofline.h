@@ -0,0 +1,212 @@
+/*{{{
+Copyright © 2018 Matthias Kretz <kretz@kde.org>
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the names of contributing organizations nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+}}}*/
+
+
+#ifndef ROOFLINE_H
+#define ROOFLINE_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include <Vc/Vc>
+#include "benchmark.h"
+
+// Roofline model: a benchmark declares the FLOPs and bytes of memory traffic per item;
+// reportRoofline() then compares the attained FLOP/s with the roof
+//   min(peak FLOP/s of V, arithmetic intensity * bandwidth of the working set's level)
+// and adds the counters
+//   Items, Bytes  the totals, as before
+//   Flops         attained FLOP/s
+//   AI            arithmetic intensity in FLOPs per byte
+//   Ridge         AI at which the kernel becomes compute bound (AI < Ridge: memory bound)
+//   Roofline      attained fraction of the roof
+// and labels the run with the cache level that holds the working set. Kernels that work
+// in registers only pass 0 bytes: their roof is the peak FLOP/s. With several threads
+// Items, Bytes and Flops are totals, AI, Ridge and Roofline are per thread, against the
+// peak of one core.
+// Peak FLOP/s (per vector type) and bandwidths (per cache level) are calibrated once per
+// process, on first use.
+
+namespace roofline_detail {
+template <class T, bool = Vc::is_simd_vector<T>::value> struct vector_for {
+  using type = T;
+};
+// plain loops over T are measured against the native vector of T
+template <class T> struct vector_for<T, false> {
+  using type = Vc::Vector<T>;
+};
+
+using clock = std::chrono::steady_clock;
+
+inline double seconds(clock::time_point start) {
+  return std::chrono::duration<double>(clock::now() - start).count();
+}
+
+// Keeps each chain in a register of its own: without it the compiler may combine the
+// scalar chains of Scalar::Vector into vector instructions and inflate its peak.
+template <class T>
+typename std::enable_if<std::is_floating_point<T>::value>::type chainBarrier(T &x) {
+  asm("" : "+x"(x));
+}
+template <class T>
+typename std::enable_if<std::is_integral<T>::value>::type chainBarrier(T &x) {
+  asm("" : "+r"(x));
+}
+template <class V>
+typename std::enable_if<!std::is_arithmetic<V>::value>::type chainBarrier(V &x) {
+  fake_modification(x);
+}
+template <class T, class A> void chainBarrier(Vc::Vector<T, A> &x) {
+  chainBarrier(x.data());
+}
+template <class T, int N>
+void chainBarrier(Vc::Vector<T, Vc::simd_abi::fixed_size<N>> &x) {
+  fake_modification(x);
+}
+
+// Independent multiply-add chains, enough to hide the latency of the FP pipelines.
+template <class V> double measurePeakFlops() {
+  using T = typename V::EntryType;
+  constexpr int Chains = 8;
+  constexpr int N = 1 << 16;
+  V a[Chains];
+  for (int k = 0; k < Chains; ++k) {
+    a[k] = V(T(k + 1));
+  }
+  V b = V(T(0.999999));
+  V c = V(T(0.000001));
+  fake_modification(b);
+  fake_modification(c);
+  double best = std::numeric_limits<double>::max();
+  for (int run = 0; run < 3; ++run) {
+    const auto start = clock::now();
+    for (int i = 0; i < N; ++i) {
+      for (int k = 0; k < Chains; ++k) {
+        a[k] = a[k] * b + c;
+        chainBarrier(a[k]);
+      }
+    }
+    best = std::min(best, seconds(start));
+  }
+  for (int k = 0; k < Chains; ++k) {
+    do_not_optimize(a[k]);
+  }
+  return 2. * Chains * N * element_count<V>::value / best;
+}
+
+// Streaming load, add, store over a working set of the given size (input + output).
+inline double measureBandwidth(std::size_t bytes) {
+  using V = Vc::float_v;
+  const std::size_t chunks = bytes / (2 * sizeof(float)) / V::size();
+  const std::size_t n = std::max<std::size_t>(chunks, 1) * V::size();
+  std::vector<float, Vc::Allocator<float>> input(n, 1.f);
+  std::vector<float, Vc::Allocator<float>> output(n);
+  const std::size_t passes = std::max<std::size_t>((std::size_t(64) << 20) / bytes, 1);
+  double best = std::numeric_limits<double>::max();
+  for (int run = 0; run < 3; ++run) {
+    const auto start = clock::now();
+    for (std::size_t pass = 0; pass < passes; ++pass) {
+      for (std::size_t i = 0; i < n; i += V::size()) {
+        (V(&input[i], Vc::Aligned) + 1.f).store(&output[i], Vc::Aligned);
+      }
+      asm volatile("" ::: "memory");
+    }
+    best = std::min(best, seconds(start));
+  }
+  return 2. * n * sizeof(float) * passes / best;
+}
+
+struct MemoryLevel {
+  std::size_t size;  // capacity in bytes; the last level (DRAM) is unbounded
+  double bandwidth;  // bytes/s
+};
+
+inline const std::vector<MemoryLevel> &memoryLevels() {
+  static const std::vector<MemoryLevel> levels = [] {
+    std::vector<MemoryLevel> r;
+    for (const auto &level : cacheLevels()) {
+      if (level.size == std::numeric_limits<std::size_t>::max()) {
+        const std::size_t largest = r.empty() ? std::size_t(8) << 20 : r.back().size;
+        r.push_back({level.size, measureBandwidth(8 * largest)});
+      } else {
+        r.push_back({level.size, measureBandwidth(level.size / 2)});
+      }
+    }
+    return r;
+  }();
+  return levels;
+}
+}  // namespace roofline_detail
+
+//! Peak FLOP/s of multiply-add on V (or on the native vector of a fundamental type V)
+template <class V> double peakFlops() {
+  static const double peak =
+      roofline_detail::measurePeakFlops<typename roofline_detail::vector_for<V>::type>();
+  return peak;
+}
+
+//! Bandwidth in bytes/s of the smallest cache level (or DRAM) that holds workingSet bytes
+inline double peakBandwidth(std::size_t workingSet) {
+  for (const auto &level : roofline_detail::memoryLevels()) {
+    if (workingSet <= level.size) {
+      return level.bandwidth;
+    }
+  }
+  return roofline_detail::memoryLevels().back().bandwidth;
+}
+
+template <class V>
+void reportRoofline(benchmark::State &state, double items, double flopsPerItem,
+                    double bytesPerItem, std::size_t workingSet) {
+  state.counters["Items"] = items;
+  if (bytesPerItem > 0) {
+    state.counters["Bytes"] = items * bytesPerItem;
+    labelCacheLevel(state, workingSet);
+  }
+  if (state.iterations() == 0 || state.error_occurred()) {
+    return;
+  }
+  const double flops = peakFlops<V>();
+  double roof = flops;
+  if (bytesPerItem > 0) {
+    const double bandwidth = peakBandwidth(workingSet);
+    const double intensity = flopsPerItem / bytesPerItem;
+    roof = std::min(flops, intensity * bandwidth);
+    state.counters["AI"] = benchmark::Counter(intensity, benchmark::Counter::kAvgThreads);
+    state.counters["Ridge"] =
+        benchmark::Counter(flops / bandwidth, benchmark::Counter::kAvgThreads);
+  }
+  state.counters["Flops"] =
+      benchmark::Counter(items * flopsPerItem, benchmark::Counter::kIsRate);
+  state.counters["Roofline"] =
+      benchmark::Counter(items * flopsPerItem / roof, benchmark::Counter::kAvgThreadsRate);
+}
+
+#endif // ROOFLINE_H
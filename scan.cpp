@@ -0,0 +1,216 @@
+/*{{{
+Copyright © 2018 Matthias Kretz <kretz@kde.org>
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the names of contributing organizations nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+}}}*/
+
+#include "benchmark.h"
+#include "roofline.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+// Inclusive and exclusive prefix sums with
+//   StdScan  std::partial_sum (inclusive) or the equivalent loop (exclusive); C++14 has
+//            no std::inclusive_scan/std::exclusive_scan
+//   LogStep  an in-register log-step scan (log2(V::size()) shifted additions) per
+//            vector, plus the running total broadcast from the previous vector
+//   TwoPass  blocked and multi-threaded: every thread sums its block, the block sums are
+//            scanned, then every thread scans its block with LogStep starting at the sum
+//            of the blocks before it. Threads are started for each pass.
+// The argument is the working set (input + output) in bytes. The inputs are the small
+// integers 0 to 3, so that int scans do not overflow (short scans wrap around, the same
+// in every method) and float scans stay exact up to 2^24. Reports the roofline counters
+// (see roofline.h) of one addition per item; TwoPass is compared with the roof of one
+// core although it runs on several.
+
+template <class T> using Array = std::vector<T, Vc::Allocator<T>>;
+
+struct Inclusive {};
+struct Exclusive {};
+
+struct StdScan {
+  template <class V, class T>
+  static void scan(const T *in, T *out, std::size_t n, Inclusive) {
+    std::partial_sum(in, in + n, out);
+  }
+  template <class V, class T>
+  static void scan(const T *in, T *out, std::size_t n, Exclusive) {
+    T sum = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      const T x = in[i];
+      out[i] = sum;
+      sum += x;
+    }
+  }
+};
+
+//! Lane i of the result is x[0] + ... + x[i]
+template <class V> inline V scanInRegister(V x) {
+  for (int shift = 1; shift < int(V::size()); shift *= 2) {
+    x += x.shifted(-shift);
+  }
+  return x;
+}
+
+//! Scans the n entries of in, starting at carry; in and out must be aligned, a partial
+//! final vector is scanned one entry at a time
+template <class V, class T>
+void scanBlock(const T *in, T *out, std::size_t n, T carry, Inclusive) {
+  constexpr std::size_t W = V::size();
+  V c = carry;
+  std::size_t i = 0;
+  for (; i + W <= n; i += W) {
+    const V s = scanInRegister(V(&in[i], Vc::Aligned)) + c;
+    s.store(&out[i], Vc::Aligned);
+    c = s[W - 1];
+  }
+  for (T sum = c[0]; i < n; ++i) {
+    sum += in[i];
+    out[i] = sum;
+  }
+}
+
+template <class V, class T>
+void scanBlock(const T *in, T *out, std::size_t n, T carry, Exclusive) {
+  constexpr std::size_t W = V::size();
+  V c = carry;
+  std::size_t i = 0;
+  for (; i + W <= n; i += W) {
+    const V x(&in[i], Vc::Aligned);
+    const V s = scanInRegister(x.shifted(-1)) + c;
+    s.store(&out[i], Vc::Aligned);
+    c = s[W - 1] + x[W - 1];
+  }
+  for (T sum = c[0]; i < n; ++i) {
+    const T x = in[i];
+    out[i] = sum;
+    sum += x;
+  }
+}
+
+struct LogStep {
+  template <class V, class T, class Kind>
+  static void scan(const T *in, T *out, std::size_t n, Kind kind) {
+    scanBlock<V>(in, out, n, T(0), kind);
+  }
+};
+
+struct TwoPass {
+  //! Calls f(b) for b = 0, ..., blocks - 1, each on its own thread
+  template <class F> static void forEachBlock(std::size_t blocks, F &&f) {
+    std::vector<std::thread> workers;
+    for (std::size_t b = 1; b < blocks; ++b) {
+      workers.emplace_back([&f, b] { f(b); });
+    }
+    f(0);
+    for (auto &worker : workers) {
+      worker.join();
+    }
+  }
+
+  template <class V, class T, class Kind>
+  static void scan(const T *in, T *out, std::size_t n, Kind kind) {
+    constexpr std::size_t W = V::size();
+    constexpr std::size_t MinBlock = std::size_t(1) << 16;
+    const std::size_t blocks = std::max<std::size_t>(
+        1, std::min<std::size_t>(std::thread::hardware_concurrency(), n / MinBlock));
+    // round the blocks up, so that the last one ends at n; every block starts aligned
+    const std::size_t perBlock = (n + blocks - 1) / blocks;
+    const std::size_t block = (perBlock + W - 1) / W * W;
+    auto range = [&](std::size_t b) {
+      const std::size_t begin = std::min(n, b * block);
+      return std::make_pair(begin, std::min(n, begin + block));
+    };
+
+    // sums[b + 1]: the sum of block b; after the scan, sums[b]: the sum before block b
+    std::vector<T> sums(blocks + 1);
+    forEachBlock(blocks, [&](std::size_t b) {
+      const auto r = range(b);
+      V sum = V::Zero();
+      std::size_t i = r.first;
+      for (; i + W <= r.second; i += W) {
+        sum += V(&in[i], Vc::Aligned);
+      }
+      T total = sum.sum();
+      for (; i < r.second; ++i) {
+        total += in[i];
+      }
+      sums[b + 1] = total;
+    });
+    std::partial_sum(sums.begin(), sums.end(), sums.begin());
+    forEachBlock(blocks, [&](std::size_t b) {
+      const auto r = range(b);
+      scanBlock<V>(in + r.first, out + r.first, r.second - r.first, sums[b], kind);
+    });
+  }
+};
+
+template <class Config> void prefixSum(benchmark::State &state) {
+  using Method = typename Config::template at<0>;
+  using Kind = typename Config::template at<1>;
+  using V = typename Config::template at<2>;
+  using T = typename entry_type<V>::type;
+  constexpr std::size_t W = element_count<V>::value;
+
+  const std::size_t n = std::max<std::size_t>(state.range(0) / (2 * sizeof(T)) / W, 1) * W;
+  Array<T> in(n);
+  {
+    Array<float> values(n);
+    fillUniform(values.data(), n, 0.f, 4.f);
+    std::transform(values.begin(), values.end(), in.begin(),
+                   [](float x) { return T(int(x)); });
+  }
+  Array<T> out(n);
+
+  for (auto _ : state) {
+    Method::template scan<V>(in.data(), out.data(), n, Kind());
+    benchmark::ClobberMemory();
+  }
+
+  Array<T> expected(n);
+  StdScan::scan<T>(in.data(), expected.data(), n, Kind());
+  for (std::size_t i = 0; i < n; ++i) {
+    // float scans are exact up to 2^24, then the order of the additions matters
+    if (std::abs(double(out[i]) - double(expected[i])) > 1e-4 * std::abs(double(expected[i]))) {
+      state.SkipWithError("the scan does not match std::partial_sum");
+      return;
+    }
+  }
+  reportRoofline<V>(state, double(state.iterations()) * n, 1, 2 * sizeof(T),
+                    2 * n * sizeof(T));
+}
+
+Vc_BENCHMARK_TEMPLATE(
+    prefixSum,
+    concat<outer_product<Typelist<StdScan>,
+                         outer_product<Typelist<Inclusive, Exclusive>,
+                                       selected_types<float, double, int, unsigned int,
+                                                      short, unsigned short>>>,
+           outer_product<Typelist<LogStep, TwoPass>,
+                         outer_product<Typelist<Inclusive, Exclusive>, all_vectors>>>)
+    ->Apply(cacheSweepOf<1>)
+    ->UseRealTime();
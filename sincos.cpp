@@ -27,23 +27,19 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 }}}*/
 
 #include "benchmark.h"
-#include <random>
-
-std::default_random_engine urbg{std::random_device()()};
 
 struct SincosInput {
   template <class T>
   typename std::enable_if<std::is_floating_point<T>::value, T>::type random_input()
       const {
-    std::uniform_real_distribution<T> dist(0, 2000 * M_PI);
-    return dist(urbg);
+    return uniformAt(0, T(0), T(2000 * M_PI));
   }
 
   template <class T>
   typename std::enable_if<Vc::is_simd_vector<T>::value, T>::type random_input()
       const {
-    std::uniform_real_distribution<typename T::value_type> dist(0, 2 * M_PI);
-    T v(dist(urbg));
+    using TY = typename T::value_type;
+    T v(uniformAt(0, TY(0), TY(2 * M_PI)));
     for (size_t i = 1; i < T::size(); ++i) {
       v[i] += 0.01f;
     }
@@ -51,9 +47,13 @@ struct SincosInput {
   }
 };
 
+// passThrough(x) has the type of the result of operator(), without computing it, for
+// the calibration of the loop overhead
 struct Sin : SincosInput {
   static constexpr std::size_t count = 1;
 
+  template <class T> static T passThrough(const T &x) { return x; }
+
   template <class T> T operator()(const T &x) const {
     using std::sin;
     return sin(x);
@@ -63,6 +63,8 @@ struct Sin : SincosInput {
 struct Cos : SincosInput {
   static constexpr std::size_t count = 1;
 
+  template <class T> static T passThrough(const T &x) { return x; }
+
   template <class T> T operator()(const T &x) const {
     using std::cos;
     return cos(x);
@@ -72,6 +74,8 @@ struct Cos : SincosInput {
 struct Sincos : SincosInput {
   static constexpr std::size_t count = 2;
 
+  template <class T> static std::pair<T, T> passThrough(const T &x) { return {x, x}; }
+
   std::pair<float, float> operator()(float x) const {
     std::pair<float, float> r;
     ::sincosf(x, &r.first, &r.second);
@@ -96,10 +100,12 @@ template <class Setup> void _(benchmark::State &state) {
   const Operation op;
   ArgType x = op.template random_input<ArgType>();
 
-  for (auto _ : state) {
+  const auto iteration = [&](auto f) {
     x += 0.0001f;
-    do_not_optimize(op(x));
-  }
+    do_not_optimize(f(x));
+  };
+  netLoop(state, [&] { iteration(op); },
+          [&] { iteration([](const ArgType &y) { return Operation::passThrough(y); }); });
   state.counters["Rate"] =
       state.iterations() * element_count<ArgType>::value * op.count;
 }
@@ -107,4 +113,24 @@ template <class Setup> void _(benchmark::State &state) {
 Vc_BENCHMARK_TEMPLATE(
     _,
     outer_product<Typelist<Sin, Cos, Sincos>,
-                  concat<float, all_vectors_of<float>, double, all_vectors_of<double>>>);
+                  concat<selected_types<float>, all_vectors_of<float>,
+                         selected_types<double>, all_vectors_of<double>>>)
+    ->SubtractOverhead()
+    ->TrackFrequency();
+
+// SMT contention, as in arithmetics.cpp
+template <class Setup> void sameCore(benchmark::State &state) { _<Setup>(state); }
+template <class Setup> void separateCores(benchmark::State &state) { _<Setup>(state); }
+
+using ContendedSincos =
+    outer_product<Typelist<Sincos>, concat<all_vectors_of<float>, all_vectors_of<double>>>;
+Vc_BENCHMARK_TEMPLATE(sameCore, ContendedSincos)
+    ->Pin(Pinning::SmtSiblings)
+    ->Threads(2)
+    ->SubtractOverhead()
+    ->TrackFrequency();
+Vc_BENCHMARK_TEMPLATE(separateCores, ContendedSincos)
+    ->Pin(Pinning::PhysicalCores)
+    ->Threads(2)
+    ->SubtractOverhead()
+    ->TrackFrequency();
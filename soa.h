@@ -24,24 +24,22 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.*/
 #ifndef SOA_H
 #define SOA_H
 
+#include <limits>
+#include <Vc/vector>
+#include "inputgenerator.h"
+
 template <typename T>
-using ArrayOfCoordinates = Coordinate<Vc::vector<T, Vc::Allocator<T>>>;
+using ArrayOfCoordinates = Coordinate<Vc::vector<T, FirstTouchAllocator<T>>>;
 template <typename T>
 using ArrayOfPolarCoordinates = PolarCoordinate<Vc::vector<T, Vc::Allocator<T>>>;
 
 //! Creates random numbers for SoA
 template <typename B, typename T>
 void simulateInputSoa(ArrayOfCoordinates<T> &input, const size_t size) {
-  using Dist = typename std::conditional<std::is_integral<B>::value,
-                                         std::uniform_int_distribution<B>,
-                                         std::uniform_real_distribution<B>>::type;
-  std::mt19937 engine(std::random_device{}());
-  Dist random(std::numeric_limits<B>::min(), std::numeric_limits<B>::max());
-
-  for (size_t n = 0; n < size; n++) {
-    input.x[n] = random(engine);
-    input.y[n] = random(engine);
-  }
+  fillUniform(input.x.data(), size, std::numeric_limits<B>::min(),
+              std::numeric_limits<B>::max(), 0);
+  fillUniform(input.y.data(), size, std::numeric_limits<B>::min(),
+              std::numeric_limits<B>::max(), 1);
 }
 
 template <typename T> struct SoaLayout {
@@ -53,11 +51,13 @@ template <typename T> struct SoaLayout {
   OC outputValues;
 
   SoaLayout(size_t containerSize) {
-    inputValues.x.reserve(containerSize);
-    inputValues.y.reserve(containerSize);
+    inputValues.x.resize(containerSize);
+    inputValues.y.resize(containerSize);
+
+    outputValues.radius.resize(containerSize);
+    outputValues.phi.resize(containerSize);
 
-    outputValues.radius.reserve(containerSize);
-    outputValues.phi.reserve(containerSize);
+    simulateInputSoa<TY>(inputValues, containerSize);
   }
 
   Coordinate<TY> coordinate(size_t index) {
@@ -121,7 +121,7 @@ template <typename T> struct LoadStoreAccessImpl : public SoaLayout<T> {
 };
 
 template <typename T> struct SoaGatherScatterAccessImpl : public SoaLayout<T> {
-  typedef typename T::IndexType IT;
+  typedef IndexesFor<T> IT;
 
   IT indexes;
 
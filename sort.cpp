@@ -0,0 +1,344 @@
+/*{{{
+Copyright © 2018 Matthias Kretz <kretz@kde.org>
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the names of contributing organizations nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+}}}*/
+
+#include "benchmark.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// Sorting 32-bit keys (float, int, unsigned) and key-value pairs with
+//   StdSort      std::sort
+//   NetworkSort  every vector sorted in registers with V::sorted(), then merge passes
+//                that merge two runs one vector at a time with a bitonic merge network
+//                (min/max against the reversed vector, then log2(V::size())
+//                half-cleaner stages of shifted min/max); keys only
+//   RadixSort    LSD radix sort with 8-bit digits; the histograms of all four digits
+//                are counted in one vectorized pass, one table per lane so that the
+//                scatter of the incremented counts has no conflicts
+// The argument is the number of keys. Every iteration sorts a fresh copy of the same
+// random input; the copy is part of the measured time. Reports Keys (keys/s).
+
+template <class T> using Array = std::vector<T, Vc::Allocator<T>>;
+
+///////////////////////////////////////////////////////////////////////////////
+// payloads
+template <class T> struct KeyValue {
+  T key;
+  unsigned value;
+};
+
+template <class T> T key(T x) { return x; }
+template <class T> T key(const KeyValue<T> &x) { return x.key; }
+
+struct Keys {
+  template <class T> using type = T;
+
+  template <class T> static T make(const T &key, std::size_t) { return key; }
+  template <class T> static bool valid(const T *, const T *, std::size_t) { return true; }
+};
+
+struct Pairs {
+  template <class T> using type = KeyValue<T>;
+
+  //! the value is the index in the input
+  template <class T> static KeyValue<T> make(const T &key, std::size_t i) {
+    return {key, unsigned(i)};
+  }
+  template <class T>
+  static bool valid(const KeyValue<T> *input, const KeyValue<T> *sorted, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+      if (sorted[i].value >= n || input[sorted[i].value].key != sorted[i].key) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+template <class T> void fillKeys(T *data, std::size_t n) {
+  fillUniform(data, n, T(-1), T(1));
+}
+inline void fillKeys(int *data, std::size_t n) { fillBits(data, n); }
+inline void fillKeys(unsigned *data, std::size_t n) { fillBits(data, n); }
+
+///////////////////////////////////////////////////////////////////////////////
+// std::sort
+struct StdSort {
+  template <class V, class R> static void sort(R *data, R *, std::size_t n) {
+    std::sort(data, data + n, [](const R &a, const R &b) { return key(a) < key(b); });
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// sorting network and bitonic merge
+constexpr int ceilLog2(std::size_t n) { return n <= 1 ? 0 : 1 + ceilLog2((n + 1) / 2); }
+
+//! The bitonic merge of two vectors; holds the lane masks of its half-cleaner stages so
+//! that they are built once per sort.
+template <class V> class BitonicMerge {
+public:
+  BitonicMerge() {
+    using T = typename V::EntryType;
+    for (std::size_t s = 0, d = V::size() / 2; d > 0; ++s, d /= 2) {
+      T pattern[V::size()];
+      for (std::size_t i = 0; i < V::size(); ++i) {
+        pattern[i] = T((i & d) != 0);
+      }
+      upper[s] = V(pattern, Vc::Unaligned) != V(T(0));
+    }
+  }
+
+  //! Given the sorted vectors lo and hi, lo receives the V::size() smallest and hi the
+  //! V::size() largest of their entries, both sorted.
+  void operator()(V &lo, V &hi) const {
+    // lo ascending, hi reversed descending: the lane-wise min and max are bitonic
+    const V reversed = hi.reversed();
+    const V l = Vc::min(lo, reversed);
+    const V h = Vc::max(lo, reversed);
+    lo = sortBitonic(l);
+    hi = sortBitonic(h);
+  }
+
+private:
+  //! Half-cleaner stages with distances V::size() / 2, ..., 1: lane i with bit d clear
+  //! takes the min, lane i + d the max of the pair
+  V sortBitonic(V x) const {
+    for (int s = 0, d = int(V::size()) / 2; d > 0; ++s, d /= 2) {
+      x = Vc::iif(upper[s], Vc::max(x, x.shifted(-d)), Vc::min(x, x.shifted(d)));
+    }
+    return x;
+  }
+
+  static constexpr int Stages = ceilLog2(V::size());
+  //! the lanes with bit d set, per stage
+  typename V::mask_type upper[Stages > 0 ? Stages : 1];
+};
+
+//! Merges the sorted runs a and b; na and nb are multiples of V::size().
+template <class V, class T>
+void mergeRuns(const BitonicMerge<V> &bitonicMerge, const T *a, std::size_t na,
+               const T *b, std::size_t nb, T *out) {
+  constexpr std::size_t W = V::size();
+  V lo(a, Vc::Aligned);
+  V hi(b, Vc::Aligned);
+  std::size_t ia = W, ib = W;
+  bitonicMerge(lo, hi);
+  lo.store(out, Vc::Aligned);
+  out += W;
+  // continue with the run whose next entry is smaller
+  while (ia < na || ib < nb) {
+    if (ib == nb || (ia < na && a[ia] < b[ib])) {
+      lo = V(a + ia, Vc::Aligned);
+      ia += W;
+    } else {
+      lo = V(b + ib, Vc::Aligned);
+      ib += W;
+    }
+    bitonicMerge(lo, hi);
+    lo.store(out, Vc::Aligned);
+    out += W;
+  }
+  hi.store(out, Vc::Aligned);
+}
+
+struct NetworkSort {
+  //! n must be a multiple of V::size()
+  template <class V, class T> static void sort(T *data, T *tmp, std::size_t n) {
+    constexpr std::size_t W = V::size();
+    for (std::size_t i = 0; i < n; i += W) {
+      V(&data[i], Vc::Aligned).sorted().store(&data[i], Vc::Aligned);
+    }
+    const BitonicMerge<V> bitonicMerge;
+    T *in = data;
+    T *out = tmp;
+    for (std::size_t run = W; run < n; run *= 2) {
+      for (std::size_t i = 0; i < n; i += 2 * run) {
+        if (i + run >= n) {
+          std::copy(in + i, in + n, out + i);
+        } else {
+          mergeRuns(bitonicMerge, in + i, run, in + i + run, std::min(run, n - i - run),
+                    out + i);
+        }
+      }
+      std::swap(in, out);
+    }
+    if (in != data) {
+      std::copy(in, in + n, data);
+    }
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// LSD radix sort
+// Keys are mapped to unsigned integers with the same order: the sign bit of int is
+// flipped, non-negative floats get the sign bit set and negative floats all bits
+// flipped.
+typedef unsigned KeyBits __attribute__((__may_alias__));
+
+template <class U> U toOrdered(U bits, float) {
+  return bits ^ ((U(0) - (bits >> 31)) | U(0x80000000u));
+}
+template <class U> U fromOrdered(U bits, float) {
+  return bits ^ (((bits >> 31) - U(1)) | U(0x80000000u));
+}
+template <class U> U toOrdered(U bits, int) { return bits ^ U(0x80000000u); }
+template <class U> U fromOrdered(U bits, int) { return bits ^ U(0x80000000u); }
+template <class U> U toOrdered(U bits, unsigned) { return bits; }
+template <class U> U fromOrdered(U bits, unsigned) { return bits; }
+
+struct RadixSort {
+  static constexpr int Digits = 4;
+  static constexpr int Buckets = 256;
+
+  template <class V, class R> static void sort(R *data, R *tmp, std::size_t n) {
+    using T = decltype(key(*data));
+    using U = Vc::SimdArray<unsigned, V::size()>;
+    using I = Vc::SimdArray<int, V::size()>;
+    constexpr std::size_t W = V::size();
+    // the keys as unsigned, Stride apart
+    constexpr int Stride = sizeof(R) / sizeof(unsigned);
+    static_assert(sizeof(T) == sizeof(unsigned) && sizeof(R) % sizeof(unsigned) == 0,
+                  "RadixSort requires 32-bit keys at the start of the record");
+    KeyBits *keys = reinterpret_cast<KeyBits *>(data);
+    unsigned *raw = reinterpret_cast<unsigned *>(data);  // for vector loads and stores
+    const I strided = I::IndexesFromZero() * Stride;
+
+    // map to ordered keys and count all digits, one table per lane
+    std::vector<unsigned> counts(Digits * W * Buckets);
+    const I lane = I::IndexesFromZero() * Buckets;
+    std::size_t i = 0;
+    for (; i + W <= n; i += W) {
+      U k = Stride == 1 ? U(&raw[i], Vc::Unaligned) : U(&raw[i * Stride], strided);
+      k = toOrdered(k, T());
+      if (Stride == 1) {
+        k.store(&raw[i], Vc::Unaligned);
+      } else {
+        k.scatter(&raw[i * Stride], strided);
+      }
+      for (int d = 0; d < Digits; ++d) {
+        const I index = Vc::simd_cast<I>((k >> (8 * d)) & U(Buckets - 1)) + lane +
+                        int(d * W * Buckets);
+        (U(&counts[0], index) + 1u).scatter(&counts[0], index);
+      }
+    }
+    for (; i < n; ++i) {
+      const unsigned k = toOrdered(unsigned(keys[i * Stride]), T());
+      keys[i * Stride] = k;
+      for (int d = 0; d < Digits; ++d) {
+        ++counts[(d * W) * Buckets + ((k >> (8 * d)) & (Buckets - 1))];
+      }
+    }
+
+    // one scatter pass per digit, skipped if all keys share that digit
+    R *in = data;
+    R *out = tmp;
+    for (int d = 0; d < Digits; ++d) {
+      std::size_t offset[Buckets];
+      std::size_t sum = 0;
+      bool trivial = false;
+      for (int b = 0; b < Buckets; ++b) {
+        offset[b] = sum;
+        std::size_t count = 0;
+        for (std::size_t l = 0; l < W; ++l) {
+          count += counts[(d * W + l) * Buckets + b];
+        }
+        trivial = trivial || count == n;
+        sum += count;
+      }
+      if (trivial) {
+        continue;
+      }
+      const KeyBits *inKeys = reinterpret_cast<const KeyBits *>(in);
+      for (std::size_t j = 0; j < n; ++j) {
+        out[offset[(inKeys[j * Stride] >> (8 * d)) & (Buckets - 1)]++] = in[j];
+      }
+      std::swap(in, out);
+    }
+    if (in != data) {
+      std::copy(in, in + n, data);
+    }
+
+    for (i = 0; i + W <= n; i += W) {
+      if (Stride == 1) {
+        fromOrdered(U(&raw[i], Vc::Unaligned), T()).store(&raw[i], Vc::Unaligned);
+      } else {
+        fromOrdered(U(&raw[i * Stride], strided), T()).scatter(&raw[i * Stride], strided);
+      }
+    }
+    for (; i < n; ++i) {
+      keys[i * Stride] = fromOrdered(unsigned(keys[i * Stride]), T());
+    }
+  }
+};
+
+template <class Config> void sortArray(benchmark::State &state) {
+  using Method = typename Config::template at<0>;
+  using Payload = typename Config::template at<1>;
+  using V = typename Config::template at<2>;
+  using T = typename entry_type<V>::type;
+  using R = typename Payload::template type<T>;
+
+  const std::size_t n = state.range(0);
+  Array<T> keys(n);
+  fillKeys(keys.data(), n);
+  Array<R> input;
+  input.reserve(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    input.push_back(Payload::make(keys[i], i));
+  }
+  Array<R> data(n);
+  Array<R> tmp(n);
+
+  for (auto _ : state) {
+    std::copy(input.begin(), input.end(), data.begin());
+    Method::template sort<V>(data.data(), tmp.data(), n);
+    benchmark::ClobberMemory();
+  }
+
+  const bool sorted = std::is_sorted(data.begin(), data.end(), [](const R &a, const R &b) {
+    return key(a) < key(b);
+  });
+  if (!sorted || !Payload::valid(input.data(), data.data(), n)) {
+    state.SkipWithError("the result is not sorted");
+    return;
+  }
+  state.counters["Keys"] =
+      benchmark::Counter(double(state.iterations()) * n, benchmark::Counter::kIsRate);
+  labelCacheLevel(state, 2 * n * sizeof(R));
+}
+
+using sort_types = selected_types<float, int, unsigned int>;
+using sort_vectors =
+    concat<all_vectors_of<float>, all_vectors_of<int>, all_vectors_of<unsigned int>>;
+
+Vc_BENCHMARK_TEMPLATE(
+    sortArray,
+    concat<outer_product<Typelist<StdSort>, outer_product<Typelist<Keys, Pairs>, sort_types>>,
+           outer_product<Typelist<NetworkSort>, outer_product<Typelist<Keys>, sort_vectors>>,
+           outer_product<Typelist<RadixSort>,
+                         outer_product<Typelist<Keys, Pairs>, sort_vectors>>>)
+    ->Range(1 << 10, 1 << 26);
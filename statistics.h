@@ -0,0 +1,137 @@
+/*{{{
+Copyright © 2018 Matthias Kretz <kretz@kde.org>
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the names of contributing organizations nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+}}}*/
+
+
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// Robust aggregates over the repetitions of one benchmark. Each function has the
+// signature benchmark::Benchmark::ComputeStatistics expects and is applied to the real
+// time, the CPU time and every counter of the repetitions.
+namespace statistics {
+inline double median(std::vector<double> v) {
+  if (v.empty()) {
+    return 0;
+  }
+  const auto mid = v.begin() + v.size() / 2;
+  std::nth_element(v.begin(), mid, v.end());
+  if (v.size() % 2 == 1) {
+    return *mid;
+  }
+  return (*mid + *std::max_element(v.begin(), mid)) * 0.5;
+}
+
+// Median absolute deviation, scaled by 1.4826 so that it estimates the standard
+// deviation of normally distributed samples.
+inline double mad(const std::vector<double> &v) {
+  const double m = median(v);
+  std::vector<double> deviation;
+  deviation.reserve(v.size());
+  for (double x : v) {
+    deviation.push_back(std::abs(x - m));
+  }
+  return 1.4826 * median(std::move(deviation));
+}
+
+// Half-width of the 95% confidence interval of the mean (Student's t distribution).
+inline double ci95(const std::vector<double> &v) {
+  static constexpr double t975[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365,
+                                    2.306,  2.262, 2.228, 2.201, 2.179, 2.160, 2.145,
+                                    2.131,  2.120, 2.110, 2.101, 2.093, 2.086, 2.080,
+                                    2.074,  2.069, 2.064, 2.060, 2.056, 2.052, 2.048,
+                                    2.045,  2.042};
+  const std::size_t n = v.size();
+  if (n < 2) {
+    return 0;
+  }
+  double mean = 0;
+  for (double x : v) {
+    mean += x;
+  }
+  mean /= n;
+  double var = 0;
+  for (double x : v) {
+    var += (x - mean) * (x - mean);
+  }
+  var /= n - 1;
+  const double t = n - 1 <= sizeof(t975) / sizeof(double) ? t975[n - 2] : 1.96;
+  return t * std::sqrt(var / n);
+}
+
+// Samples further than this many (scaled) MADs from the median count as outliers.
+constexpr double outlierThreshold = 3;
+
+// Mean after warm-up detection and outlier rejection: leading repetitions are dropped
+// until the first one that lies within the outlier band around the median; of the rest,
+// outliers are rejected. A ramping clock frequency or cold caches thus only affect the
+// first repetitions, while the steady-state mean ignores them.
+inline double steadyMean(const std::vector<double> &v) {
+  if (v.empty()) {
+    return 0;
+  }
+  const double m = median(v);
+  // a zero MAD (e.g. a counter that is constant over all repetitions) must not reject
+  // everything that differs from the median by rounding
+  const double band = std::max(outlierThreshold * mad(v), 1e-9 * std::abs(m));
+  auto inBand = [&](double x) { return std::abs(x - m) <= band; };
+  auto first = std::find_if(v.begin(), v.end(), inBand);
+  double sum = 0;
+  std::size_t n = 0;
+  for (; first != v.end(); ++first) {
+    if (inBand(*first)) {
+      sum += *first;
+      ++n;
+    }
+  }
+  return n == 0 ? m : sum / n;
+}
+
+// Relative change from the first to the last quarter of the repetitions, in order:
+// mean(last quarter) / mean(first quarter) - 1. Over a soak run (see
+// TemplateWrapper::Soak) a positive drift of the time, or a negative drift of a rate or
+// of GHz, shows thermal throttling.
+inline double drift(const std::vector<double> &v) {
+  const std::size_t quarter = std::max<std::size_t>(v.size() / 4, 1);
+  if (v.size() < 2) {
+    return 0;
+  }
+  double first = 0, last = 0;
+  for (std::size_t i = 0; i < quarter; ++i) {
+    first += v[i];
+    last += v[v.size() - 1 - i];
+  }
+  return first == 0 ? 0 : last / first - 1;
+}
+
+}  // namespace statistics
+
+#endif // STATISTICS_H
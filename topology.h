@@ -0,0 +1,240 @@
+/*{{{
+Copyright © 2018 Matthias Kretz <kretz@kde.org>
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the names of contributing organizations nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+}}}*/
+
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <tuple>
+#include <vector>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Thread placement for multi-threaded benchmarks. The CPU topology is read from
+// /sys/devices/system/cpu, restricted to the CPUs the process may run on. A pinning
+// policy orders these CPUs; benchmark thread i runs on the i-th CPU of that order:
+//   Compact        fill one core after the other, using all of its SMT siblings
+//   Scatter        spread over packages and cores first, SMT siblings only at the end
+//   PhysicalCores  one thread per core, never two on the siblings of a core
+//   SmtSiblings    like Compact, but only cores with at least two hardware threads, so
+//                  that threads 2k and 2k + 1 always share a core
+// Runs with more threads than the policy has CPUs are skipped with an error.
+
+enum class Pinning { None, Compact, Scatter, PhysicalCores, SmtSiblings };
+
+inline const char *pinningName(Pinning p) {
+  switch (p) {
+  case Pinning::None:          return "none";
+  case Pinning::Compact:       return "compact";
+  case Pinning::Scatter:       return "scatter";
+  case Pinning::PhysicalCores: return "physical-cores";
+  case Pinning::SmtSiblings:   return "smt-siblings";
+  }
+  return "?";
+}
+
+struct LogicalCpu {
+  int id;
+  int core;     // core_id, unique only within the package
+  int package;  // physical_package_id
+  int sibling;  // index among the hardware threads of its core
+  int siblings; // number of hardware threads of its core
+};
+
+namespace topology_detail {
+inline int readInt(const std::string &path, int fallback) {
+  std::ifstream file(path);
+  int value;
+  return file >> value ? value : fallback;
+}
+}  // namespace topology_detail
+
+//! The CPUs this process may run on, ordered by id
+inline const std::vector<LogicalCpu> &cpuTopology() {
+  static const std::vector<LogicalCpu> cpus = [] {
+    std::vector<LogicalCpu> r;
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    sched_getaffinity(0, sizeof(allowed), &allowed);
+    for (int id = 0; id < CPU_SETSIZE; ++id) {
+      if (CPU_ISSET(id, &allowed)) {
+        const std::string dir =
+            "/sys/devices/system/cpu/cpu" + std::to_string(id) + "/topology/";
+        // without topology information every CPU counts as a core of its own
+        r.push_back({id, topology_detail::readInt(dir + "core_id", id),
+                     topology_detail::readInt(dir + "physical_package_id", 0), 0, 1});
+      }
+    }
+#endif
+    for (auto &cpu : r) {
+      for (const auto &other : r) {
+        if (other.package == cpu.package && other.core == cpu.core) {
+          cpu.sibling += other.id < cpu.id;
+          cpu.siblings += other.id != cpu.id;
+        }
+      }
+    }
+    return r;
+  }();
+  return cpus;
+}
+
+//! The CPUs in the order the policy assigns them to benchmark threads
+inline std::vector<int> pinningOrder(Pinning policy) {
+  std::vector<LogicalCpu> cpus = cpuTopology();
+  const auto compact = [](const LogicalCpu &a, const LogicalCpu &b) {
+    return std::tie(a.package, a.core, a.sibling) < std::tie(b.package, b.core, b.sibling);
+  };
+  std::sort(cpus.begin(), cpus.end(), compact);
+  switch (policy) {
+  case Pinning::None:
+    return {};
+  case Pinning::Compact:
+    break;
+  case Pinning::Scatter: {
+    // rank of the core within its package, then round robin over the packages
+    std::vector<int> rank(cpus.size());
+    for (std::size_t i = 0, r = 0; i < cpus.size(); ++i) {
+      const bool newPackage = i == 0 || cpus[i].package != cpus[i - 1].package;
+      const bool newCore = newPackage || cpus[i].core != cpus[i - 1].core;
+      r = newPackage ? 0 : r + newCore;
+      rank[i] = int(r);
+    }
+    for (std::size_t i = 0; i < cpus.size(); ++i) {
+      cpus[i].core = rank[i];
+    }
+    std::sort(cpus.begin(), cpus.end(), [](const LogicalCpu &a, const LogicalCpu &b) {
+      return std::tie(a.sibling, a.core, a.package) < std::tie(b.sibling, b.core, b.package);
+    });
+    break;
+  }
+  case Pinning::PhysicalCores:
+    cpus.erase(std::remove_if(cpus.begin(), cpus.end(),
+                              [](const LogicalCpu &c) { return c.sibling != 0; }),
+               cpus.end());
+    break;
+  case Pinning::SmtSiblings:
+    cpus.erase(std::remove_if(cpus.begin(), cpus.end(),
+                              [](const LogicalCpu &c) {
+                                // an odd last sibling would pair with the next core
+                                return c.siblings < 2 || c.sibling >= c.siblings / 2 * 2;
+                              }),
+               cpus.end());
+    break;
+  }
+  std::vector<int> order;
+  for (const auto &cpu : cpus) {
+    order.push_back(cpu.id);
+  }
+  return order;
+}
+
+// google benchmark 1.6 turned State::threads and State::thread_index into functions
+namespace topology_detail {
+template <class State>
+auto threads(const State &state, int) -> decltype(int(state.threads())) {
+  return state.threads();
+}
+template <class State>
+auto threads(const State &state, long) -> decltype(int(state.threads)) {
+  return state.threads;
+}
+template <class State>
+auto threadIndex(const State &state, int) -> decltype(int(state.thread_index())) {
+  return state.thread_index();
+}
+template <class State>
+auto threadIndex(const State &state, long) -> decltype(int(state.thread_index)) {
+  return state.thread_index;
+}
+}  // namespace topology_detail
+
+//! The number of threads running the benchmark
+inline int benchmarkThreads(const benchmark::State &state) {
+  return topology_detail::threads(state, 0);
+}
+
+//! The index of the calling benchmark thread, from 0 to benchmarkThreads(state) - 1
+inline int benchmarkThreadIndex(const benchmark::State &state) {
+  return topology_detail::threadIndex(state, 0);
+}
+
+//! Pins the calling benchmark thread according to the policy for the lifetime of the
+//! object and restores its previous affinity afterwards. Thread 0 labels the run with
+//! the policy and the CPUs of all threads, e.g. "compact: 0,8,1,9".
+class ScopedPinning {
+public:
+  ScopedPinning(benchmark::State &state, Pinning policy) {
+    if (policy == Pinning::None) {
+      return;
+    }
+    const std::vector<int> order = pinningOrder(policy);
+    if (order.size() < std::size_t(benchmarkThreads(state))) {
+      state.SkipWithError("not enough CPUs for this pinning policy");
+      return;
+    }
+#ifdef __linux__
+    pinned = pthread_getaffinity_np(pthread_self(), sizeof(previous), &previous) == 0;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(order[benchmarkThreadIndex(state)], &set);
+    pinned = pinned && pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#endif
+    if (benchmarkThreadIndex(state) == 0) {
+      std::string label = std::string(pinningName(policy)) + ':';
+      for (int i = 0; i < benchmarkThreads(state); ++i) {
+        label += (i == 0 ? " " : ",") + std::to_string(order[i]);
+      }
+      state.SetLabel(label);
+    }
+  }
+
+  ~ScopedPinning() {
+#ifdef __linux__
+    if (pinned) {
+      pthread_setaffinity_np(pthread_self(), sizeof(previous), &previous);
+    }
+#endif
+  }
+
+  ScopedPinning(const ScopedPinning &) = delete;
+  ScopedPinning &operator=(const ScopedPinning &) = delete;
+
+private:
+#ifdef __linux__
+  cpu_set_t previous;
+#endif
+  bool pinned = false;
+};
+
+#endif // TOPOLOGY_H
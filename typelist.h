@@ -30,183 +30,127 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <Vc/vector.h>
 #include <type_traits>
+#include <utility>
 
 template <typename... Ts> struct Typelist;
-// concat {{{
-template <typename... More> struct concat_impl;
-/**
- * Concatenate two type arguments into a single Typelist.
- */
-template <typename... Ts> using concat = typename concat_impl<Ts...>::type;
+// All metafunctions below have constant instantiation depth (independent of the list
+// lengths), so that products of thousands of types still compile quickly.
 
-// concat implementation:
-template <typename A> struct concat_impl<A> {
-    using type = A;
-};
-template <typename A, typename B> struct concat_impl<A, B> {
-    using type = Typelist<A, B>;
-};
-template <typename... As, typename B> struct concat_impl<Typelist<As...>, B> {
-    using type = Typelist<As..., B>;
+// extract_type {{{
+struct TypelistSentinel;
+#if defined __has_builtin
+#if __has_builtin(__type_pack_element)
+#define Vc_HAVE_TYPE_PACK_ELEMENT 1
+#endif
+#endif
+
+#ifndef Vc_HAVE_TYPE_PACK_ELEMENT
+// Fallback: derive from one base per (index, type) pair and let overload resolution
+// pick the base with the requested index.
+template <std::size_t N, typename T> struct indexed_type
+{
+    using type = T;
 };
-template <typename A, typename... Bs> struct concat_impl<A, Typelist<Bs...>> {
-    using type = Typelist<A, Bs...>;
+template <typename Is, typename... Ts> struct type_indexer;
+template <std::size_t... Is, typename... Ts>
+struct type_indexer<std::index_sequence<Is...>, Ts...> : indexed_type<Is, Ts>...
+{
 };
-template <typename... As, typename... Bs>
-struct concat_impl<Typelist<As...>, Typelist<Bs...>> {
-    using type = Typelist<As..., Bs...>;
+template <std::size_t N, typename T> indexed_type<N, T> select_type(indexed_type<N, T>);
+#endif
+
+template <std::size_t N, bool InRange, typename... Ts> struct extract_type_impl
+{
+    using type = TypelistSentinel;
 };
-template <typename A, typename B, typename C, typename... More>
-struct concat_impl<A, B, C, More...> {
-    using type = typename concat_impl<typename concat_impl<A, B>::type, C, More...>::type;
+template <std::size_t N, typename... Ts> struct extract_type_impl<N, true, Ts...>
+{
+#ifdef Vc_HAVE_TYPE_PACK_ELEMENT
+    using type = __type_pack_element<N, Ts...>;
+#else
+    using type = typename decltype(
+        select_type<N>(type_indexer<std::index_sequence_for<Ts...>, Ts...>()))::type;
+#endif
 };
-// }}}
-// outer_product {{{
-template <typename A, typename B> struct outer_product_impl;
-template <typename... Bs> struct outer_product_impl<Typelist<>, Typelist<Bs...>>
+
+/**
+ * The N-th type of Ts, or TypelistSentinel if N is out of range.
+ */
+template <std::size_t N, typename... Ts>
+using extract_type = typename extract_type_impl<N, (N < sizeof...(Ts)), Ts...>::type;
+
+template <typename... Ts> struct Typelist
 {
-    using type = Typelist<>;
+    template <std::size_t N> using at = extract_type<N, Ts...>;
+
+    static constexpr std::size_t size() { return sizeof...(Ts); }
 };
-template <typename A0, typename... Bs>
-struct outer_product_impl<Typelist<A0>, Typelist<Bs...>>
+// }}}
+// concat {{{
+template <typename T> struct as_typelist
 {
-    using type = Typelist<concat<A0, Bs>...>;
+    using type = Typelist<T>;
 };
-template <typename A0, typename... As, typename... Bs>
-struct outer_product_impl<Typelist<A0, As...>, Typelist<Bs...>>
+template <typename... Ts> struct as_typelist<Typelist<Ts...>>
 {
-    using type =
-        concat<Typelist<concat<A0, Bs>...>,
-               typename outer_product_impl<Typelist<As...>, Typelist<Bs...>>::type>;
+    using type = Typelist<Ts...>;
 };
 
-template <typename A, typename B>
-using outer_product = typename outer_product_impl<A, B>::type;
-// }}}
-// extract_type_impl {{{
-struct TypelistSentinel;
-template <std::size_t N, bool N_less_4, bool N_larger_32, typename... Ts>
-struct extract_type_impl
+template <typename... Lists> struct join_impl;
+template <> struct join_impl<>
 {
-    using type = TypelistSentinel;
+    using type = Typelist<>;
 };
-template <typename T0, typename... Ts> struct extract_type_impl<0, true, false, T0, Ts...>
+template <typename... As> struct join_impl<Typelist<As...>>
 {
-    using type = T0;
+    using type = Typelist<As...>;
 };
-template <typename T0, typename T1, typename... Ts>
-struct extract_type_impl<1, true, false, T0, T1, Ts...>
+template <typename... As, typename... Bs, typename... Cs, typename... Ds,
+          typename... More>
+struct join_impl<Typelist<As...>, Typelist<Bs...>, Typelist<Cs...>, Typelist<Ds...>,
+                 More...>
+    : join_impl<Typelist<As..., Bs..., Cs..., Ds...>, More...>
 {
-    using type = T1;
 };
-template <typename T0, typename T1, typename T2, typename... Ts>
-struct extract_type_impl<2, true, false, T0, T1, T2, Ts...>
+template <typename... As, typename... Bs, typename... Cs>
+struct join_impl<Typelist<As...>, Typelist<Bs...>, Typelist<Cs...>>
 {
-    using type = T2;
+    using type = Typelist<As..., Bs..., Cs...>;
 };
-template <typename T0, typename T1, typename T2, typename T3, typename... Ts>
-struct extract_type_impl<3, true, false, T0, T1, T2, T3, Ts...>
+template <typename... As, typename... Bs>
+struct join_impl<Typelist<As...>, Typelist<Bs...>>
 {
-    using type = T3;
+    using type = Typelist<As..., Bs...>;
 };
-template <std::size_t N,
-          typename T00,
-          typename T01,
-          typename T02,
-          typename T03,
-          typename T04,
-          typename T05,
-          typename T06,
-          typename T07,
-          typename T08,
-          typename T09,
-          typename T10,
-          typename T11,
-          typename T12,
-          typename T13,
-          typename T14,
-          typename T15,
-          typename T16,
-          typename T17,
-          typename T18,
-          typename T19,
-          typename T20,
-          typename T21,
-          typename T22,
-          typename T23,
-          typename T24,
-          typename T25,
-          typename T26,
-          typename T27,
-          typename T28,
-          typename T29,
-          typename T30,
-          typename T31,
-          typename... Ts>
-struct extract_type_impl<N,
-                    false,
-                    true,
-                    T00,
-                    T01,
-                    T02,
-                    T03,
-                    T04,
-                    T05,
-                    T06,
-                    T07,
-                    T08,
-                    T09,
-                    T10,
-                    T11,
-                    T12,
-                    T13,
-                    T14,
-                    T15,
-                    T16,
-                    T17,
-                    T18,
-                    T19,
-                    T20,
-                    T21,
-                    T22,
-                    T23,
-                    T24,
-                    T25,
-                    T26,
-                    T27,
-                    T28,
-                    T29,
-                    T30,
-                    T31,
-                    Ts...>
+
+template <typename... More> struct concat_impl
 {
-    static constexpr std::size_t NN = N - 32;
-    using type = typename extract_type_impl<NN, (NN < 4), (NN >= 32), Ts...>::type;
+    using type = typename join_impl<typename as_typelist<More>::type...>::type;
 };
-
-template <std::size_t N,
-          typename T0,
-          typename T1,
-          typename T2,
-          typename T3,
-          typename... Ts>
-struct extract_type_impl<N, false, false, T0, T1, T2, T3, Ts...>
+template <typename A> struct concat_impl<A>
 {
-    static constexpr std::size_t NN = N - 4;
-    using type = typename extract_type_impl<NN, (NN < 4), (NN >= 32), Ts...>::type;
+    using type = A;
 };
-
-template <std::size_t N, typename... Ts>
-using extract_type = typename extract_type_impl<N, (N < 4), (N >= 32), Ts...>::type;
-
-template <typename... Ts> struct Typelist
+/**
+ * Concatenate type arguments into a single Typelist. Typelist arguments are flattened
+ * (one level), other arguments become one element each. A single argument is returned
+ * unchanged.
+ */
+template <typename... Ts> using concat = typename concat_impl<Ts...>::type;
+// }}}
+// outer_product {{{
+// Element K of the product combines element K / |B| of A with element K % |B| of B.
+template <typename A, typename B, typename Ks> struct outer_product_impl;
+template <typename... As, typename... Bs, std::size_t... Ks>
+struct outer_product_impl<Typelist<As...>, Typelist<Bs...>, std::index_sequence<Ks...>>
 {
-    template <std::size_t N>
-    using at = typename extract_type_impl<N, (N < 4), (N >= 32), Ts...>::type;
-
-    static constexpr std::size_t size() { return sizeof...(Ts); }
+    using type = Typelist<concat<extract_type<Ks / sizeof...(Bs), As...>,
+                                 extract_type<Ks % sizeof...(Bs), Bs...>>...>;
 };
 
+template <typename A, typename B>
+using outer_product = typename outer_product_impl<
+    A, B, std::make_index_sequence<A::size() * B::size()>>::type;
 // }}}
 // static_asserts {{{
 static_assert(std::is_same<outer_product<Typelist<int, float>, Typelist<short, double>>,
@@ -228,23 +172,99 @@ static_assert(
                  Typelist<char, float, short>,
                  Typelist<char, float, double>>>::value,
     "outer_product does not work as expected");
+static_assert(std::is_same<outer_product<Typelist<>, Typelist<int>>, Typelist<>>::value,
+              "outer_product with an empty list must be empty");
+static_assert(std::is_same<outer_product<Typelist<int>, Typelist<>>, Typelist<>>::value,
+              "outer_product with an empty list must be empty");
+static_assert(std::is_same<concat<int>, int>::value, "concat does not work as expected");
+static_assert(std::is_same<concat<Typelist<int>, float, Typelist<>, Typelist<char, long>,
+                                  Typelist<Typelist<short>>>,
+                           Typelist<int, float, char, long, Typelist<short>>>::value,
+              "concat does not work as expected");
+static_assert(std::is_same<Typelist<int, float, char>::at<0>, int>::value &&
+                  std::is_same<Typelist<int, float, char>::at<2>, char>::value,
+              "Typelist::at does not work as expected");
+static_assert(std::is_same<Typelist<int, float, char>::at<3>, TypelistSentinel>::value &&
+                  std::is_same<Typelist<>::at<0>, TypelistSentinel>::value,
+              "Typelist::at must return TypelistSentinel when out of range");
 // }}}
 
+// configure-time selection {{{
+// VC_BENCH_TYPES and VC_BENCH_ABIS (see CMakeLists.txt) define Vc_BENCH_TYPES and
+// Vc_BENCH_ABIS as comma separated type lists. Without them everything is selected.
+namespace BenchAbi
+{
+struct Scalar;
+struct SSE;
+struct AVX2;
+struct SimdArray;
+}  // namespace BenchAbi
+
+/**
+ * Whether T is one of the elements of List.
+ */
+template <typename List, typename T> struct contains;
+template <typename... Ts, typename T>
+struct contains<Typelist<Ts...>, T>
+    : std::integral_constant<
+          bool, !std::is_same<std::integer_sequence<bool, std::is_same<T, Ts>::value...>,
+                              std::integer_sequence<bool, (sizeof(Ts *), false)...>>::value>
+{
+};
+
+#ifdef Vc_BENCH_TYPES
+template <typename T> using is_selected_type = contains<Typelist<Vc_BENCH_TYPES>, T>;
+#else
+template <typename T> using is_selected_type = std::true_type;
+#endif
+#ifdef Vc_BENCH_ABIS
+template <typename Abi> using is_selected_abi = contains<Typelist<Vc_BENCH_ABIS>, Abi>;
+#else
+template <typename Abi> using is_selected_abi = std::true_type;
+#endif
+
+template <bool Selected, typename... Ts>
+using select_if = typename std::conditional<Selected, Typelist<Ts...>, Typelist<>>::type;
+
+/**
+ * The Typelist of those Ts that are selected element types.
+ */
+template <typename... Ts>
+using selected_types = concat<select_if<is_selected_type<Ts>::value, Ts>...>;
+// }}}
+// static_asserts {{{
+static_assert(contains<Typelist<int, float>, float>::value &&
+                  !contains<Typelist<int, float>, double>::value &&
+                  !contains<Typelist<>, int>::value,
+              "contains does not work as expected");
+// }}}
+
+template <class T, std::size_t... Ns>
+using simdarrays_of = select_if<is_selected_type<T>::value &&
+                                    is_selected_abi<BenchAbi::SimdArray>::value,
+                                Vc::SimdArray<T, Ns>...>;
+
 template <class T, bool WithSimdArray = true>
-using all_vectors_of =
-    concat<Vc::Scalar::Vector<T>,
-           Typelist<
+using all_vectors_of = typename std::conditional<
+    is_selected_type<T>::value,
+    concat<select_if<is_selected_abi<BenchAbi::Scalar>::value, Vc::Scalar::Vector<T>>,
+           typename std::conditional<is_selected_abi<BenchAbi::SSE>::value,
+                                     Typelist<
 #ifdef Vc_IMPL_SSE2
-               Vc::SSE::Vector<T>
+                                         Vc::SSE::Vector<T>
 #endif
-               >,
-           Typelist<
+                                         >,
+                                     Typelist<>>::type,
+           typename std::conditional<is_selected_abi<BenchAbi::AVX2>::value,
+                                     Typelist<
 #ifdef Vc_IMPL_AVX2
-               Vc::AVX2::Vector<T>
+                                         Vc::AVX2::Vector<T>
 #endif
-               >,
-           typename std::conditional<WithSimdArray, Typelist<Vc::SimdArray<T, 16>>,
-                                     Typelist<>>::type>;
+                                         >,
+                                     Typelist<>>::type,
+           typename std::conditional<WithSimdArray, simdarrays_of<T, 16>,
+                                     Typelist<>>::type>,
+    Typelist<>>::type;
 
 using all_real_vectors_wo_simdarray =
     concat<all_vectors_of<float, false>, all_vectors_of<double, false>>;